@@ -0,0 +1,59 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <atomic>
+#include <utility>
+
+using namespace std;
+
+// Unbounded lock-free multi-producer single-consumer queue. A producer
+// links its node with a single atomic exchange and never waits; only the
+// thread that owns the channel may pop.
+template <typename T>
+class Channel
+{
+public:
+    Channel() : head(new Node), tail(head.load()) {}
+
+    ~Channel()
+    {
+        T value;
+        while (pop(value))
+            ;
+        delete tail;
+    }
+
+    void push(T value)
+    {
+        Node *node = new Node;
+        node->value = move(value);
+        Node *previous = head.exchange(node, memory_order_acq_rel);
+        previous->next.store(node, memory_order_release);
+    }
+
+    bool pop(T &value)
+    {
+        Node *next = tail->next.load(memory_order_acquire);
+        if (next == nullptr)
+            return false;
+        value = move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        atomic<Node *> next{nullptr};
+        T value;
+    };
+
+    Channel(const Channel &);
+    Channel &operator=(const Channel &);
+
+    atomic<Node *> head;
+    Node *tail;
+};
+
+#endif
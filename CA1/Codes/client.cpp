@@ -100,36 +100,29 @@ void intiFileDescriptorSet(int &max_sd, fd_set &master_set, int &server_socket,
     if (STDIN_FILENO > max_sd)
         max_sd = STDIN_FILENO;
     FD_SET(STDIN_FILENO, &master_set);
-
-    if (STDOUT_FILENO > max_sd)
-        max_sd = STDOUT_FILENO;
-    FD_SET(STDOUT_FILENO, &master_set);
 }
 
-pair<string, string> extractPatternAndMessage(const std::string &str)
+string roomListMessage(const char *title, const Frame &frame)
 {
-    pair<string, string> info;
-    size_t first_star = str.find(STAR.c_str());
-    size_t second_star = str.find(STAR.c_str(), first_star + 1);
-
-    info.first = str.substr(first_star + 1, second_star - first_star - 1);
-    info.second = str.substr(second_star + 1);
-
-    return info;
-}
-
-void alarmHandler(int sig)
-{
-    TIME_OVER = 1;
+    PayloadReader payload(frame);
+    string message = title;
+    while (!payload.atEnd())
+    {
+        uint32_t room = payload.u32();
+        if (!payload.ok())
+            break;
+        message += "\nRoom " + to_string(room);
+    }
+    return message + "\n";
 }
 
 string encodedMoveChoice(int room_number, int player_number, char *buffer)
 {
-    int move = atoi(buffer);
-    string encoded_message = STAR + ENCODED_CHOICE_OPC + STAR;
-    encoded_message += to_string(room_number) + STAR + to_string(player_number) +
-                       STAR + to_string(move);
-    return encoded_message;
+    string payload;
+    appendU32(payload, room_number);
+    appendU8(payload, player_number);
+    appendU8(payload, atoi(buffer));
+    return encodeFrame(Opcode::MOVE, payload);
 }
 
 void signalHandler(int signal)
@@ -137,14 +130,88 @@ void signalHandler(int signal)
     exit(EXIT_SUCCESS);
 }
 
-void readAndSendBack(char *buffer, string &read_state, int &server_socket)
+// The server owns the move deadline: a move is sent as soon as it is typed,
+// and one typed after the game was judged is ignored by the server.
+void readAndSendBack(char *buffer, ClientState &state)
 {
-    read(STDIN_FILENO, buffer, 1024);
-    string buf_str(buffer);
+    memset(buffer, 0, BUFFER_SIZE);
+    read(STDIN_FILENO, buffer, BUFFER_SIZE - 1);
+    string payload(buffer);
+    if (!payload.empty() && payload.back() == '\n')
+        payload.pop_back();
+
+    string frame;
+    if (state.read_state == Opcode::MOVE)
+        frame = encodedMoveChoice(state.room_number, state.player_number, buffer);
+    else if (state.read_state == Opcode::ROOM_CHOICE && atoi(buffer) == 0)
+    {
+        logMsg(MATCHMAKING_MESSAGE);
+        frame = encodeFrame(Opcode::MATCHMAKE);
+    }
+    else if (state.read_state == Opcode::ROOM_CHOICE)
+    {
+        payload.clear();
+        appendU32(payload, atoi(buffer));
+        frame = encodeFrame(state.read_state, payload);
+    }
+    else
+        frame = encodeFrame(state.read_state, payload);
 
-    buf_str = STAR.c_str() + read_state + STAR.c_str() + buf_str;
-    send(server_socket, buf_str.c_str(), strlen(buf_str.c_str()), 0);
-    read_state = NO_READ;
+    send(state.server_socket, frame.data(), frame.size(), 0);
+    state.read_state = Opcode::NONE;
+}
+
+void handleFrame(const Frame &frame, ClientState &state)
+{
+    PayloadReader payload(frame);
+
+    if (frame.opcode == Opcode::NAME_PROMPT)
+    {
+        logMsg(RECEIVE_NAME_MESSAGE);
+        state.read_state = Opcode::NAME;
+    }
+    else if (frame.opcode == Opcode::ROOM_LIST || frame.opcode == Opcode::ROOM_UNAVAILABLE)
+    {
+        const char *title = frame.opcode == Opcode::ROOM_LIST ? RECEIVE_ROOM_NUMBER_MESSAGE : ROOM_UNAVAILABLE_MESSAGE;
+        logMsg(roomListMessage(title, frame).c_str());
+        state.read_state = Opcode::ROOM_CHOICE;
+    }
+    else if (frame.opcode == Opcode::ROOM_UPDATE)
+    {
+        // Only a player choosing a room is shown the changes.
+        while (state.read_state == Opcode::ROOM_CHOICE && !payload.atEnd())
+        {
+            uint32_t room = payload.u32();
+            bool available = payload.u8();
+            if (!payload.ok())
+                break;
+            string message = "Room " + to_string(room) + (available ? ROOM_FREE_MESSAGE : ROOM_FULL_MESSAGE);
+            logMsg(message.c_str());
+        }
+    }
+    else if (frame.opcode == Opcode::PLAYER1 || frame.opcode == Opcode::PLAYER2)
+    {
+        // Moves name the room the server seated this player in.
+        bool first = frame.opcode == Opcode::PLAYER1;
+        logMsg(first ? FIRST_PLAYER_MESSAGE : SECOND_PLAYER_MESSAGE);
+        state.player_number = first ? PLAYER_1 : PLAYER_2;
+        state.room_number = payload.u32();
+    }
+    else if (frame.opcode == Opcode::CHOOSE_MOVE)
+    {
+        logMsg(CHOOSE_MOVE_MESSAGE);
+        state.read_state = Opcode::MOVE;
+    }
+    else if (frame.opcode == Opcode::JUDGE_RESULT)
+    {
+        string message = payload.rest();
+        write(STDOUT_FILENO, message.c_str(), message.size());
+    }
+    else if (frame.opcode == Opcode::FINAL)
+    {
+        logMsg(payload.rest().c_str());
+        exit(EXIT_SUCCESS);
+    }
 }
 
 int main(int argc, char const *argv[])
@@ -166,95 +233,53 @@ int main(int argc, char const *argv[])
 
     signal(SIGINT, signalHandler);
 
-    int room_connected, player_number, room_number;
+    ClientState state;
+    state.server_socket = server_socket;
+    state.read_state = Opcode::NONE;
+    state.player_number = None;
+    state.room_number = None;
 
-    string read_state = NO_READ;
     char buff[BUFFER_SIZE] = {0};
+    vector<char> datagram(DATAGRAM_SIZE);
+    FrameBuffer server_frames;
+    Frame frame;
 
     while (1)
     {
+        // Input typed before the server asks for it waits in stdin.
         working_set = master_set;
+        if (state.read_state == Opcode::NONE)
+            FD_CLR(STDIN_FILENO, &working_set);
         select(max_sd + 1, &working_set, NULL, NULL, NULL);
 
         for (int i = 0; i <= max_sd; i++)
         {
-            if (FD_ISSET(i, &working_set))
-            {
-                if (i == STDIN_FILENO && read_state != NO_READ)
-                    readAndSendBack(buff, read_state, server_socket);
-                else
-                    recv(i, buff, BUFFER_SIZE, 0);
-
-                string new_message(buff), pattern, message;
-
-                pair<string, string> info = extractPatternAndMessage(new_message);
-                pattern = info.first;
-                message = info.second;
-
-                if (pattern == NAME_INP_OPC)
-                {
-                    logMsg(message.c_str());
-                    memset(buff, 0, BUFFER_SIZE);
-                    read_state = NAME_INP_OPC;
-                }
-                if (pattern == ROOM_CHOOSE_OPC)
-                {
-                    logMsg(message.c_str());
-                    memset(buff, 0, BUFFER_SIZE);
-                    read_state = ROOM_CHOOSE_OPC;
-                }
-                else if (pattern == CONNECT_WITH_ROOM_OPC)
-                {
-                    int port_num = stoi(message);
-                    room_connected = connectServer(port_num, ip);
-                    room_number = port_num - port;
+            if (!FD_ISSET(i, &working_set))
+                continue;
 
-                    if (room_connected > max_sd)
-                        max_sd = room_connected;
-                    FD_SET(room_connected, &master_set);
-                }
-                else if (pattern == PLAYER1_OPC)
-                {
-                    logMsg(message.c_str());
-                    player_number = PLAYER_1;
-                }
-                else if (pattern == PLAYER2_OPC)
-                {
-                    logMsg(message.c_str());
-                    player_number = PLAYER_2;
-                }
-                else if (pattern == GAME_BEGIN_OPC)
-                {
-                    logMsg(message.c_str());
-                    signal(SIGALRM, alarmHandler);
-                    siginterrupt(SIGALRM, 1);
-
-                    alarm(TIME_OUT);
-                    memset(buff, 0, BUFFER_SIZE);
-                    read(STDIN_FILENO, buff, BUFFER_SIZE);
-                    while (true)
-                        if (TIME_OVER)
-                        {
-                            if (player_number == PLAYER_2)
-                                this_thread::sleep_for(chrono::milliseconds(TIME_OUT));
-                            string message = encodedMoveChoice(room_number, player_number, buff);
-                            send(room_connected, message.c_str(), strlen(message.c_str()), 0);
-                            TIME_OVER = false;
-                            break;
-                        }
-                }
-                else if (pattern == JUDGE_RESULT_OPC)
-                    write(STDOUT_FILENO, message.c_str(), strlen(message.c_str()));
-                else if (pattern == FINAL_MSG_OPC)
+            if (i == STDIN_FILENO)
+                readAndSendBack(buff, state);
+            else if (i == server_socket)
+            {
+                ssize_t received = recv(server_socket, buff, BUFFER_SIZE, 0);
+                if (received <= 0)
                 {
-                    logMsg(message.c_str());
-                    exit(EXIT_SUCCESS);
+                    logError(SERVER_CLOSED.c_str());
+                    exit(EXIT_FAILURE);
                 }
 
-                memset(buff, 0, BUFFER_SIZE);
+                server_frames.append(buff, received);
+                while (server_frames.next(frame))
+                    handleFrame(frame, state);
+            }
+            else if (i == broadcast_socket)
+            {
+                ssize_t received = recv(broadcast_socket, datagram.data(), datagram.size(), 0);
+                if (received > 0 && decodeFrame(datagram.data(), received, frame))
+                    handleFrame(frame, state);
             }
         }
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,132 @@
+#include "protocol.h"
+
+#include <arpa/inet.h>
+#include <string.h>
+
+void appendU8(string &payload, uint8_t value)
+{
+    payload.push_back((char)value);
+}
+
+void appendU32(string &payload, uint32_t value)
+{
+    uint32_t network = htonl(value);
+    payload.append((const char *)&network, sizeof(network));
+}
+
+string encodeFrame(Opcode opcode, const string &payload)
+{
+    string frame;
+    frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    startFrame(frame, opcode);
+    frame += payload;
+    finishFrame(frame);
+    return frame;
+}
+
+void startFrame(string &frame, Opcode opcode)
+{
+    frame.clear();
+    appendU8(frame, PROTOCOL_VERSION);
+    appendU8(frame, (uint8_t)opcode);
+    appendU32(frame, 0);
+}
+
+void finishFrame(string &frame)
+{
+    uint32_t length = htonl(frame.size() - FRAME_HEADER_SIZE);
+    memcpy(&frame[2], &length, sizeof(length));
+}
+
+// Parses a header at data; returns false if it is not a valid one.
+static bool decodeHeader(const char *data, Frame &frame)
+{
+    uint32_t length;
+    memcpy(&length, data + 2, sizeof(length));
+    frame.opcode = (Opcode)(uint8_t)data[1];
+    frame.length = ntohl(length);
+    frame.payload = data + FRAME_HEADER_SIZE;
+    return (uint8_t)data[0] == PROTOCOL_VERSION && frame.length <= MAX_FRAME_PAYLOAD;
+}
+
+PayloadReader::PayloadReader(const Frame &frame)
+    : data(frame.payload), length(frame.length), offset(0), valid(true) {}
+
+uint8_t PayloadReader::u8()
+{
+    if (length - offset < 1)
+    {
+        valid = false;
+        return 0;
+    }
+    return (uint8_t)data[offset++];
+}
+
+uint32_t PayloadReader::u32()
+{
+    uint32_t value;
+    if (length - offset < sizeof(value))
+    {
+        valid = false;
+        return 0;
+    }
+    memcpy(&value, data + offset, sizeof(value));
+    offset += sizeof(value);
+    return ntohl(value);
+}
+
+string PayloadReader::rest()
+{
+    string value(data + offset, length - offset);
+    offset = length;
+    return value;
+}
+
+bool PayloadReader::ok() const
+{
+    return valid;
+}
+
+bool PayloadReader::atEnd() const
+{
+    return offset == length;
+}
+
+FrameBuffer::FrameBuffer() : start(0), broken(false) {}
+
+void FrameBuffer::append(const char *data, size_t length)
+{
+    // Consumed frames are dropped here, never in next(), so payloads handed
+    // out by next() stay in place until the caller reads more.
+    buffer.erase(0, start);
+    start = 0;
+    buffer.append(data, length);
+}
+
+bool FrameBuffer::next(Frame &frame)
+{
+    if (broken || buffer.size() - start < FRAME_HEADER_SIZE)
+        return false;
+
+    if (!decodeHeader(buffer.data() + start, frame))
+    {
+        broken = true;
+        return false;
+    }
+    if (buffer.size() - start - FRAME_HEADER_SIZE < frame.length)
+        return false;
+
+    start += FRAME_HEADER_SIZE + frame.length;
+    return true;
+}
+
+bool FrameBuffer::corrupt() const
+{
+    return broken;
+}
+
+bool decodeFrame(const char *data, size_t length, Frame &frame)
+{
+    return length >= FRAME_HEADER_SIZE && decodeHeader(data, frame) &&
+           frame.length == length - FRAME_HEADER_SIZE;
+}
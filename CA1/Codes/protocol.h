@@ -0,0 +1,96 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+using namespace std;
+
+// Wire format shared by the server and the client. Every message is one
+// frame: a version byte, an opcode byte and a big-endian 32-bit payload
+// length, followed by the payload. Integers inside payloads are big-endian.
+const uint8_t PROTOCOL_VERSION = 1;
+const size_t FRAME_HEADER_SIZE = 6;
+const uint32_t MAX_FRAME_PAYLOAD = 1 << 22;
+
+enum class Opcode : uint8_t
+{
+    NONE = 0,             // never sent; marks that no input is expected
+    NAME_PROMPT = 1,      // server: ask for a name
+    NAME = 2,             // client: player name
+    ROOM_LIST = 3,        // server: u32 numbers of the rooms with a free seat
+    ROOM_CHOICE = 4,      // client: u32 room number
+    ROOM_UNAVAILABLE = 5, // server: like ROOM_LIST, after a rejected choice
+    PLAYER1 = 6,          // server: u32 room, joined as player 1, wait for an opponent
+    PLAYER2 = 7,          // server: u32 room, joined as player 2
+    CHOOSE_MOVE = 8,      // server: both players are in, send a move
+    MOVE = 9,             // client: u32 room, u8 player, u8 move
+    JUDGE_RESULT = 10,    // broadcast: result text
+    FINAL = 11,           // broadcast: win count table text
+    ROOM_UPDATE = 12,     // server: (u32 room, u8 has a free seat) per changed room
+    MATCHMAKE = 13        // client: pair me with the next waiting player
+};
+
+// A decoded frame. payload points into the buffer it was decoded from.
+struct Frame
+{
+    Opcode opcode;
+    const char *payload;
+    uint32_t length;
+};
+
+void appendU8(string &payload, uint8_t value);
+void appendU32(string &payload, uint32_t value);
+string encodeFrame(Opcode opcode, const string &payload = string());
+
+// Encode a frame in place: startFrame() replaces the contents of frame with
+// a header, the payload is appended, and finishFrame() fills in its length.
+// frame keeps its capacity, so a reused buffer stops allocating.
+void startFrame(string &frame, Opcode opcode);
+void finishFrame(string &frame);
+
+// Reads payload fields in order. A read past the end returns zero and
+// clears ok(), so a short payload is rejected once it has been parsed.
+class PayloadReader
+{
+public:
+    explicit PayloadReader(const Frame &frame);
+
+    uint8_t u8();
+    uint32_t u32();
+    string rest();
+    bool ok() const;
+    bool atEnd() const;
+
+private:
+    const char *data;
+    size_t length;
+    size_t offset;
+    bool valid;
+};
+
+// Reassembles frames from a byte stream. TCP may split a frame across reads
+// or deliver several frames in one, so bytes are buffered until a whole
+// frame is present. A frame of another protocol version, or one longer than
+// MAX_FRAME_PAYLOAD, marks the stream corrupt.
+class FrameBuffer
+{
+public:
+    FrameBuffer();
+
+    void append(const char *data, size_t length);
+    // The payload stays valid until the next call to append.
+    bool next(Frame &frame);
+    bool corrupt() const;
+
+private:
+    string buffer;
+    size_t start;
+    bool broken;
+};
+
+// Decodes a datagram, which carries exactly one frame.
+bool decodeFrame(const char *data, size_t length, Frame &frame);
+
+#endif
@@ -0,0 +1,111 @@
+#include "reactor.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "logger.h"
+
+const int MAX_EVENTS = 256;
+
+Reactor::Reactor()
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0)
+    {
+        logError("Epoll creation failed.");
+        exit(EXIT_FAILURE);
+    }
+}
+
+Reactor::~Reactor()
+{
+    for (EventHandler *handler : handlers)
+        delete handler;
+    for (EventHandler *handler : retired)
+        delete handler;
+    close(epoll_fd);
+}
+
+bool Reactor::add(int fd, EventHandler *handler, uint32_t events)
+{
+    struct epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    if (fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        delete handler;
+        return false;
+    }
+
+    if ((size_t)fd >= handlers.size())
+        handlers.resize(fd + 1, nullptr);
+    handlers[fd] = handler;
+    return true;
+}
+
+void Reactor::remove(int fd)
+{
+    if (handler(fd) == nullptr)
+        return;
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    retired.push_back(handlers[fd]);
+    handlers[fd] = nullptr;
+}
+
+void Reactor::flushAfterBatch(int fd)
+{
+    flushing.push_back(fd);
+}
+
+EventHandler *Reactor::handler(int fd) const
+{
+    if (fd < 0 || (size_t)fd >= handlers.size())
+        return nullptr;
+    return handlers[fd];
+}
+
+void Reactor::run()
+{
+    struct epoll_event events[MAX_EVENTS];
+    while (1)
+    {
+        int ready = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+        if (ready < 0 && errno != EINTR)
+        {
+            logError("Epoll wait failed.");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int i = 0; i < ready; i++)
+        {
+            // A handler earlier in the batch may have removed this one.
+            EventHandler *current = handler(events[i].data.fd);
+            if (current)
+                current->handleEvent(events[i].events);
+        }
+
+        // Flushing may remove handlers, so it runs before retired ones go.
+        for (size_t i = 0; i < flushing.size(); i++)
+        {
+            EventHandler *current = handler(flushing[i]);
+            if (current)
+                current->flush();
+        }
+        flushing.clear();
+
+        for (EventHandler *handler : retired)
+            delete handler;
+        retired.clear();
+    }
+}
+
+int setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0)
+        return flags;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
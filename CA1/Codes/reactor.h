@@ -0,0 +1,48 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <vector>
+
+using namespace std;
+
+// Reacts to readiness on one file descriptor. Sockets are registered
+// edge-triggered, so a handler must drain its descriptor until it would block.
+class EventHandler
+{
+public:
+    virtual ~EventHandler() {}
+    virtual void handleEvent(uint32_t events) = 0;
+    virtual void flush() {}
+};
+
+// epoll event loop dispatching to one handler per descriptor. Handlers are
+// looked up by fd in a dense table, so a wakeup costs O(ready descriptors).
+// The reactor owns registered handlers; remove() unregisters a descriptor
+// and deletes its handler once the current batch of events is dispatched,
+// so a handler may remove itself or another handler from inside handleEvent.
+// flushAfterBatch() defers a handler's flush() to the end of the current
+// batch, so output queued for it by several events leaves in one write.
+class Reactor
+{
+public:
+    Reactor();
+    ~Reactor();
+
+    bool add(int fd, EventHandler *handler, uint32_t events = EPOLLIN | EPOLLET);
+    void remove(int fd);
+    void flushAfterBatch(int fd);
+    EventHandler *handler(int fd) const;
+    void run();
+
+private:
+    int epoll_fd;
+    vector<EventHandler *> handlers;
+    vector<EventHandler *> retired;
+    vector<int> flushing;
+};
+
+int setNonBlocking(int fd);
+
+#endif
@@ -15,10 +15,199 @@
 #include <thread>
 #include <sstream>
 #include <signal.h>
+#include <errno.h>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
 
 #include "logger.h"
+#include "reactor.h"
+#include "channel.h"
+#include "protocol.h"
+#include "timer.h"
 #include "types.h"
 
+struct PlayerRecord
+{
+    string name;
+    atomic<int> wins{0};
+};
+
+// Interns player names: a name gets a dense id once, when a player names
+// themselves, and rooms, sessions and win counts refer to players by id.
+// Records are allocated in chunks that never move, so any shard can read a
+// name or count a win without the lock that guards interning.
+class PlayerTable
+{
+public:
+    PlayerTable() : chunks(new atomic<PlayerRecord *>[MAX_PLAYER_CHUNKS]()), count(0) {}
+
+    ~PlayerTable()
+    {
+        for (int i = 0; i < MAX_PLAYER_CHUNKS; i++)
+            delete[] chunks[i].load();
+    }
+
+    // Returns None once the table is full.
+    int intern(const string &name)
+    {
+        lock_guard<mutex> guard(lock);
+        auto found = ids.find(name);
+        if (found != ids.end())
+            return found->second;
+
+        int player = count.load(memory_order_relaxed);
+        if (player == PLAYER_CHUNK_SIZE * MAX_PLAYER_CHUNKS)
+            return None;
+        atomic<PlayerRecord *> &chunk = chunks[player / PLAYER_CHUNK_SIZE];
+        if (chunk.load(memory_order_relaxed) == nullptr)
+            chunk.store(new PlayerRecord[PLAYER_CHUNK_SIZE], memory_order_release);
+        chunk.load(memory_order_relaxed)[player % PLAYER_CHUNK_SIZE].name = name;
+
+        ids[name] = player;
+        count.store(player + 1, memory_order_release);
+        return player;
+    }
+
+    PlayerRecord &operator[](int player) const
+    {
+        return chunks[player / PLAYER_CHUNK_SIZE].load(memory_order_acquire)[player % PLAYER_CHUNK_SIZE];
+    }
+
+    int size() const
+    {
+        return count.load(memory_order_acquire);
+    }
+
+private:
+    mutable mutex lock;
+    unordered_map<string, int> ids;
+    unique_ptr<atomic<PlayerRecord *>[]> chunks;
+    atomic<int> count;
+};
+
+struct Server;
+
+// One reactor thread. A lobby connection belongs to the shard whose
+// listener accepted it and room i belongs to shard i % shards; state is only
+// touched by its owning thread. Work on another shard's state is posted to
+// that shard's inbox, which wakes its reactor through wake_fd. Deadlines of
+// the shard's rooms run on its timer wheel.
+struct Shard
+{
+    int id;
+    Server *server;
+    Reactor reactor;
+    TimerWheel timers;
+    int wake_fd;
+    atomic<bool> wake_pending{false};
+    Channel<function<void()>> inbox;
+    vector<Session> sessions;
+    uint32_t next_serial = 0;
+    string room_list;
+    uint64_t room_list_version = UINT64_MAX;
+    vector<int> lobby;
+    string room_updates;
+    char buffer[BUFFER_SIZE];
+};
+
+// free_rooms is the availability index: one bit per room, set while the
+// room has a free seat. Only the room's owner flips a room's bit; it then
+// bumps rooms_version, which invalidates the shards' cached room lists.
+// empty_rooms has a bit set while a room has nobody in it.
+//
+// Players asking to be matched are pushed on match_queue from any shard.
+// Shard 0 is its only consumer: it keeps the players it could not pair yet
+// in match_waiting and raises match_pending while a pair is waiting for an
+// empty room, so that owners emptying a room wake it.
+struct Server
+{
+    int port;
+    int rooms_number;
+    vector<Room> rooms;
+    unique_ptr<atomic<uint64_t>[]> free_rooms;
+    unique_ptr<atomic<uint64_t>[]> empty_rooms;
+    atomic<uint64_t> rooms_version{0};
+    struct broadcast_info bc_address;
+    vector<unique_ptr<Shard>> shards;
+    PlayerTable players;
+    Channel<RoomPlayer> match_queue;
+    atomic<bool> match_pending{false};
+    vector<RoomPlayer> match_waiting;
+    int match_cursor = 0;
+};
+
+thread_local Shard *current_shard = nullptr;
+
+Shard &roomOwner(Server &server, int room)
+{
+    return *server.shards[room % server.shards.size()];
+}
+
+void wakeShard(Shard &shard)
+{
+    uint64_t one = 1;
+    if (!shard.wake_pending.exchange(true))
+        write(shard.wake_fd, &one, sizeof(one));
+}
+
+// Runs task on shard's thread: immediately when already there, otherwise
+// through its inbox. Only a task that has to be posted is wrapped in a
+// function.
+template <typename Task>
+void runOn(Shard &shard, Task task)
+{
+    if (current_shard == &shard)
+    {
+        task();
+        return;
+    }
+    shard.inbox.push(function<void()>(move(task)));
+    wakeShard(shard);
+}
+
+void sendFrame(Shard &shard, int fd, const string &frame);
+
+// The lobby holds the connections choosing a room, which are the ones told
+// about rooms filling up and freeing. Both calls are O(1).
+void enterLobby(Shard &shard, int fd)
+{
+    Session &session = shard.sessions[fd];
+    if (session.lobby_index != None)
+        return;
+    session.lobby_index = shard.lobby.size();
+    shard.lobby.push_back(fd);
+}
+
+void leaveLobby(Shard &shard, int fd)
+{
+    Session &session = shard.sessions[fd];
+    if (session.lobby_index == None)
+        return;
+    int moved = shard.lobby.back();
+    shard.lobby[session.lobby_index] = moved;
+    shard.sessions[moved].lobby_index = session.lobby_index;
+    shard.lobby.pop_back();
+    session.lobby_index = None;
+}
+
+// Runs on the player's shard; a player whose connection has closed since
+// joining gets nothing, even if a new connection reuses the fd.
+void sendToPlayer(Server &server, const RoomPlayer &player, const string &frame)
+{
+    Shard *owner = server.shards[player.shard].get();
+    runOn(*owner, [owner, player, frame]()
+          {
+              if (owner->sessions[player.fd].serial == player.serial)
+                  sendFrame(*owner, player.fd, frame); });
+}
+
 int setupSocket()
 {
     int server_socket = socket(AF_INET, SOCK_STREAM, 0);
@@ -66,17 +255,33 @@ void startListening(int server_socket)
     }
 }
 
-int setupServer(int port, const char *ip)
+int setupServer(int port, const char *ip, bool reuse_port = false)
 {
     int server_socket = setupSocket();
     int opt = 1;
     setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuse_port)
+        setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
     struct sockaddr_in server_address = defineAddress(port, ip);
     bindSocket(server_socket, server_address);
     startListening(server_socket);
+    setNonBlocking(server_socket);
     return server_socket;
 }
 
+// The shards' lobby sockets share the port through SO_REUSEPORT, which would
+// also let them join the group of another server already running on it. A
+// plain bind first fails while anything is listening there, so a second
+// server still stops with BIND_FAILED.
+void checkPortIsFree(int port, const char *ip)
+{
+    int probe = setupSocket();
+    int opt = 1;
+    setsockopt(probe, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    bindSocket(probe, defineAddress(port, ip));
+    close(probe);
+}
+
 int setBroadcastSocket()
 {
     int broadcast = 1, opt = 1;
@@ -91,6 +296,7 @@ struct broadcast_info connectBroadcastSocket()
     int socket = setBroadcastSocket();
     struct sockaddr_in bc_address = defineAddress(BROADCAST_PORT, BROADCAST_IP.c_str());
     bind(socket, (struct sockaddr *)&bc_address, sizeof(bc_address));
+    setNonBlocking(socket);
 
     struct broadcast_info bc_inf;
     bc_inf.sock = socket;
@@ -99,20 +305,26 @@ struct broadcast_info connectBroadcastSocket()
     return bc_inf;
 }
 
-void terminateGame(char *buffer, map<string, int> players_win_count, struct broadcast_info bc_address)
+void terminateGame(string command, Server &server)
 {
-    read(STDIN_FILENO, buffer, BUFFER_SIZE);
-    string buf_str(buffer);
-    buf_str.pop_back();
+    if (!command.empty() && command.back() == '\n')
+        command.pop_back();
 
-    if (buf_str == END_GAME_COMMAND)
+    if (command == END_GAME_COMMAND)
     {
+        struct broadcast_info &bc_address = server.bc_address;
+        vector<pair<string, int>> table;
+        for (int player = 0; player < server.players.size(); player++)
+            table.push_back(make_pair(server.players[player].name, server.players[player].wins.load()));
+        sort(table.begin(), table.end());
+
         string final_msg = END_GAME_MESSAGE;
-        for (const auto &pair : players_win_count)
+        for (const auto &pair : table)
         {
             final_msg = final_msg + pair.first + ": " + to_string(pair.second) + "\n";
         }
-        sendto(bc_address.sock, final_msg.c_str(), strlen(final_msg.c_str()),
+        string frame = encodeFrame(Opcode::FINAL, final_msg);
+        sendto(bc_address.sock, frame.data(), frame.size(),
                0, (struct sockaddr *)&bc_address.bc_address, sizeof(bc_address.bc_address));
     }
 }
@@ -126,135 +338,211 @@ int acceptClient(int server_socket)
     return client_fd;
 }
 
-vector<Room> setupRooms(int port, const char *ip, int number_of_rooms)
+// Rooms are logical: they are addressed by number on the lobby connection
+// and own no sockets, so any number of them costs one listening port.
+// Each room formats its result announcements once, up front.
+vector<Room> setupRooms(int number_of_rooms)
 {
-    vector<Room> rooms;
-    for (int i = 1; i <= number_of_rooms; i++)
+    vector<Room> rooms(number_of_rooms);
+    for (int i = 0; i < number_of_rooms; i++)
     {
-        struct Room new_room;
-        new_room.room_socket = setupServer(port + i, ip);
-        new_room.room_number = i;
-        rooms.push_back(new_room);
+        rooms[i].room_number = i + 1;
+        rooms[i].win_result = " in the room " + to_string(i + 1) + " won the game!\n";
+        rooms[i].tie_result = encodeFrame(Opcode::JUDGE_RESULT, "\nThe game in the room " + to_string(i + 1) + " was a tie!\n");
     }
     return rooms;
 }
 
-void intiFileDescriptorSet(int &server_socket, fd_set &master_set, int &max_sd,
-                           int rooms_number, vector<Room> &rooms, struct broadcast_info &bc_address)
+void resolveGame(Server &server, int needed_room);
+
+// Tells a player the room it was seated in, which a matched player did not
+// choose itself.
+string seatFrame(Opcode opcode, int current_room)
 {
-    FD_ZERO(&master_set);
-    max_sd = server_socket;
-    FD_SET(server_socket, &master_set);
+    string payload;
+    appendU32(payload, current_room + 1);
+    return encodeFrame(opcode, payload);
+}
 
-    for (int i = 0; i < rooms_number; i++)
+// Players are numbered in the order they joined the room. Once both are
+// asked for a move, the room's owner gives them MOVE_TIMEOUT_MS to answer.
+void askPlayersToMove(Server &server, int current_room)
+{
+    Room &room = server.rooms[current_room];
+    if (!room.asked_player1_choice)
+    {
+        room.asked_player1_choice = true;
+        sendToPlayer(server, room.players[0], seatFrame(Opcode::PLAYER1, current_room));
+    }
+    else if (!room.asked_player2_choice)
     {
-        FD_SET(rooms[i].room_socket, &master_set);
-        if (rooms[i].room_socket > max_sd)
-            max_sd = rooms[i].room_socket;
+        room.asked_player2_choice = true;
+        sendToPlayer(server, room.players[1], seatFrame(Opcode::PLAYER2, current_room));
+        sendToPlayer(server, room.players[0], encodeFrame(Opcode::CHOOSE_MOVE));
+        sendToPlayer(server, room.players[1], encodeFrame(Opcode::CHOOSE_MOVE));
+        room.deadline = roomOwner(server, current_room).timers.schedule(MOVE_TIMEOUT_MS, [&server, current_room]()
+                                                                         { resolveGame(server, current_room); });
     }
+}
 
-    FD_SET(STDIN_FILENO, &master_set);
-    if (STDIN_FILENO > max_sd)
-        max_sd = STDIN_FILENO;
+bool isFull(const Room &room)
+{
+    return room.players.size() == MAX_CLIENTS;
+}
 
-    FD_SET(bc_address.sock, &master_set);
-    if (bc_address.sock > max_sd)
-        max_sd = bc_address.sock;
+// Every shard collects the changes posted to it while it drains its inbox
+// and sends them to its lobby as one ROOM_UPDATE frame.
+void postRoomUpdate(Shard &shard, int room, bool available)
+{
+    Shard *target = &shard;
+    target->inbox.push([target, room, available]()
+                       {
+                           appendU32(target->room_updates, room + 1);
+                           appendU8(target->room_updates, available); });
+    wakeShard(shard);
 }
 
-void askPlayersToMove(vector<Room> &rooms, int current_room, int new_socket)
+// Runs on the room's owner. Returns whether the bit changed.
+bool setRoomBit(atomic<uint64_t> *bitmap, int room, bool set)
 {
-    if (!rooms[current_room].asked_player1_choice)
-    {
-        rooms[current_room].asked_player1_choice = true;
-        rooms[current_room].player_1 = new_socket;
-        send(rooms[current_room].player_1, FIRST_PLAYER_MESSAGE, strlen(FIRST_PLAYER_MESSAGE), 0);
-    }
-    else if (!rooms[current_room].asked_player2_choice)
-    {
-        rooms[current_room].asked_player2_choice = true;
-        rooms[current_room].player_2 = new_socket;
-        send(rooms[current_room].player_2, SECOND_PLAYER_MESSAGE, strlen(SECOND_PLAYER_MESSAGE), 0);
-        send(rooms[current_room].player_1, CHOOSE_MOVE_MESSAGE, strlen(CHOOSE_MOVE_MESSAGE), 0);
-        std::this_thread::sleep_for(chrono::milliseconds(10));
-        send(rooms[current_room].player_2, CHOOSE_MOVE_MESSAGE, strlen(CHOOSE_MOVE_MESSAGE), 0);
-    }
+    uint64_t bit = 1ull << (room % ROOMS_PER_WORD);
+    atomic<uint64_t> &word = bitmap[room / ROOMS_PER_WORD];
+    if (((word.load(memory_order_relaxed) & bit) != 0) == set)
+        return false;
+    if (set)
+        word.fetch_or(bit);
+    else
+        word.fetch_and(~bit);
+    return true;
 }
 
-pair<string, string> extractPatternAndMessage(const string &str)
+// Runs on the room's owner after a player joins or the room is cleared. A
+// room that filled up or freed its seats flips its bit in the index and
+// every shard hears about it; a room that emptied wakes the matchmaker if
+// a pair is waiting for one. Other changes cost nothing.
+void updateAvailability(Server &server, int room)
 {
-    pair<string, string> info;
-    size_t first_star = str.find(STAR.c_str());
-    size_t second_star = str.find(STAR.c_str(), first_star + 1);
+    if (setRoomBit(server.empty_rooms.get(), room, server.rooms[room].players.empty()) &&
+        server.rooms[room].players.empty() && server.match_pending.load())
+        wakeShard(*server.shards[0]);
 
-    info.first = str.substr(first_star + 1, second_star - first_star - 1);
-    info.second = str.substr(second_star + 1);
+    bool available = !isFull(server.rooms[room]);
+    if (!setRoomBit(server.free_rooms.get(), room, available))
+        return;
 
-    return info;
+    server.rooms_version.fetch_add(1, memory_order_release);
+
+    for (auto &shard : server.shards)
+        postRoomUpdate(*shard, room, available);
+}
+
+void publishRoomUpdates(Shard &shard)
+{
+    string frame = encodeFrame(Opcode::ROOM_UPDATE, shard.room_updates);
+    shard.room_updates.clear();
+
+    // Walks backwards so that a player dropped by sendFrame, whose place is
+    // taken by the last one, does not make the walk skip anybody.
+    for (int k = (int)shard.lobby.size() - 1; k >= 0; k--)
+        sendFrame(shard, shard.lobby[k], frame);
 }
 
-int getRoomNumber(int rooms_number, int socket, const vector<struct Room> &rooms)
+// A ROOM_LIST frame naming every room with a free seat, read off the
+// availability index a word at a time. Each shard keeps the encoded list
+// and rebuilds it in place only after the rooms changed.
+const string &generateRoomList(Shard &shard)
 {
-    for (int i = 0; i < rooms_number; i++)
-        if (socket == rooms[i].room_socket)
+    Server &server = *shard.server;
+    uint64_t version = server.rooms_version.load(memory_order_acquire);
+    if (version != shard.room_list_version)
+    {
+        startFrame(shard.room_list, Opcode::ROOM_LIST);
+        int words = (server.rooms_number + ROOMS_PER_WORD - 1) / ROOMS_PER_WORD;
+        for (int w = 0; w < words; w++)
         {
-            return i;
+            uint64_t free_bits = server.free_rooms[w].load(memory_order_relaxed);
+            for (; free_bits != 0; free_bits &= free_bits - 1)
+                appendU32(shard.room_list, w * ROOMS_PER_WORD + __builtin_ctzll(free_bits) + 1);
         }
-
-    return ROOM_NOT_FOUND;
+        finishFrame(shard.room_list);
+        shard.room_list_version = version;
+    }
+    return shard.room_list;
 }
 
-bool isFull(Room room)
+string unavailableRoomList(Shard &shard)
 {
-    return room.players.size() == MAX_CLIENTS;
+    return encodeFrame(Opcode::ROOM_UNAVAILABLE, generateRoomList(shard).substr(FRAME_HEADER_SIZE));
 }
 
-string generateRoomList(int rooms_number, const std::vector<struct Room> &rooms)
+// Runs on the player's shard, which answers from its own cached list. From
+// then on the player holds no seat, is in the lobby and follows the list
+// through updates.
+void sendRoomList(Server &server, const RoomPlayer &player, Opcode opcode = Opcode::ROOM_LIST)
 {
-    string msg_to_send;
+    Shard *owner = server.shards[player.shard].get();
+    runOn(*owner, [owner, player, opcode]()
+          {
+              Session &session = owner->sessions[player.fd];
+              if (session.serial != player.serial)
+                  return;
+              session.room = None;
+              session.player_number = None;
+              enterLobby(*owner, player.fd);
+              if (opcode == Opcode::ROOM_LIST)
+                  sendFrame(*owner, player.fd, generateRoomList(*owner));
+              else
+                  sendFrame(*owner, player.fd, unavailableRoomList(*owner)); });
+}
 
-    for (int i = 0; i < rooms_number; i++)
-    {
-        if (!isFull(rooms[i]))
-            msg_to_send = msg_to_send + "\nRoom " + to_string(i + 1);
-    }
-    msg_to_send = msg_to_send + "\n";
+void leaveRoom(Server &server, int needed_room, const RoomPlayer &player);
 
-    return msg_to_send;
+// Runs on the player's shard, ahead of the frames that start the game, so
+// the player's moves are routed by its session from the first one.
+void seatPlayer(Server &server, const RoomPlayer &player, int current_room, int player_number)
+{
+    Shard &shard = *server.shards[player.shard];
+    runOn(shard, [&shard, player, current_room, player_number]()
+          {
+              Session &session = shard.sessions[player.fd];
+              if (session.serial == player.serial)
+              {
+                  session.room = current_room;
+                  session.player_number = player_number;
+                  session.matchmaking = false;
+                  leaveLobby(shard, player.fd);
+              }
+              else
+              {
+                  // Closed while it was being seated: give the seat back. This
+                  // is posted even to the own shard, as the owner is still
+                  // in the middle of seating.
+                  Server &server = *shard.server;
+                  Shard &owner = roomOwner(server, current_room);
+                  owner.inbox.push([&server, current_room, player]()
+                                   { leaveRoom(server, current_room, player); });
+                  wakeShard(owner);
+              } });
 }
 
-void saveAndConnectToTheRoom(vector<Room> &rooms, int current_room, int rooms_number, int port, int &socket_num)
+// Runs on the room's owner; replies go back through the player's shard.
+// Joining is the whole handshake: the game starts on the lobby connection.
+void saveAndConnectToTheRoom(Server &server, int current_room, const RoomPlayer &player)
 {
+    vector<Room> &rooms = server.rooms;
     if (isFull(rooms[current_room]))
     {
-        string msg_to_send = ROOM_UNAVAILABLE_MESSAGE + generateRoomList(rooms_number, rooms);
-        send(socket_num, msg_to_send.c_str(), strlen(msg_to_send.c_str()), 0);
+        sendRoomList(server, player, Opcode::ROOM_UNAVAILABLE);
     }
     else
     {
-        rooms[current_room].players.push_back(socket_num);
-        string msg_to_send = STAR + CONNECT_WITH_ROOM_OPC + STAR + to_string(port + current_room + 1);
-        send(socket_num, msg_to_send.c_str(), strlen(msg_to_send.c_str()), 0);
+        rooms[current_room].players.push_back(player);
+        updateAvailability(server, current_room);
+        seatPlayer(server, player, current_room, rooms[current_room].players.size());
+        askPlayersToMove(server, current_room);
     }
 }
 
-vector<string> extractInfo(const string &str)
-{
-    vector<string> result;
-    size_t start = 0;
-    size_t end = str.find(STAR);
-
-    while (end != string::npos)
-    {
-        result.push_back(str.substr(start, end - start));
-        start = end + 1;
-        end = str.find(STAR, start);
-    }
-    result.push_back(str.substr(start));
-
-    return result;
-}
-
 int judge(int p1, int p2)
 {
     if (p1 == p2)
@@ -273,38 +561,67 @@ void signalHandler(int signal)
     exit(EXIT_SUCCESS);
 }
 
-void clearRoomSession(vector<Room> &rooms, int needed_room, fd_set &master_set)
+void withdrawFromMatch(Server &server, const RoomPlayer &player);
+
+// A player who asked for a room is taken out of it by the room's owner, and
+// one waiting for a match is taken out of the queue by shard 0.
+void closeClient(Shard &shard, int fd)
 {
-    FD_CLR(rooms[needed_room].player_1, &master_set);
-    close(rooms[needed_room].player_1);
+    if (shard.reactor.handler(fd) == nullptr)
+        return;
+
+    Session &session = shard.sessions[fd];
+    Server &server = *shard.server;
+    RoomPlayer player = {shard.id, fd, session.serial, session.player};
+    if (session.room != None)
+    {
+        int needed_room = session.room;
+        runOn(roomOwner(server, needed_room), [&server, needed_room, player]()
+              { leaveRoom(server, needed_room, player); });
+    }
+    else if (session.matchmaking)
+    {
+        runOn(*server.shards[0], [&server, player]()
+              { withdrawFromMatch(server, player); });
+    }
+    leaveLobby(shard, fd);
+    session = Session();
 
-    FD_CLR(rooms[needed_room].player_2, &master_set);
-    close(rooms[needed_room].player_2);
+    shard.reactor.remove(fd);
+    close(fd);
+}
+
+void clearRoomSession(Server &server, int needed_room)
+{
+    vector<Room> &rooms = server.rooms;
 
     rooms[needed_room].asked_player1_choice = false;
     rooms[needed_room].asked_player2_choice = false;
 
     rooms[needed_room].p1_choice = rooms[needed_room].p2_choice = rooms[needed_room].winner = FAILED;
+    rooms[needed_room].deadline = 0;
     rooms[needed_room].players.clear();
+    updateAvailability(server, needed_room);
 }
 
-string examineGameResult(vector<Room> rooms, map<int, string> players_names, map<string, int> &players_win_count, int needed_room)
+// The JUDGE_RESULT frame for a judged room. A tie is announced with the
+// room's preformatted frame; a win is encoded into the room's reusable
+// buffer, so announcing a result allocates nothing once it has grown.
+const string &examineGameResult(Server &server, int needed_room)
 {
-    string message;
-    if (rooms[needed_room].winner != DRAW)
-    {
-        string name_of_winner = players_names[rooms[needed_room].players[rooms[needed_room].winner - 1]];
-        players_win_count[name_of_winner]++;
-
-        message = STAR + JUDGE_RESULT_OPC + STAR + "\nPlayer " + name_of_winner + 
-                  " in the room " + to_string(needed_room + 1) + " won the game!\n";
-    }
-    else
-    {
-        message = STAR + JUDGE_RESULT_OPC + STAR + "\nThe game in the room " + to_string(needed_room + 1) +
-                  " was a tie!\n";
-    }
-    return message;
+    Room &room = server.rooms[needed_room];
+    if (room.winner == DRAW)
+        return room.tie_result;
+
+    PlayerRecord &winner = server.players[room.players[room.winner - 1].player];
+    winner.wins++;
+
+    startFrame(room.result, Opcode::JUDGE_RESULT);
+    room.result += "\nPlayer ";
+    room.result += winner.name;
+    room.result += room.win_result;
+    finishFrame(room.result);
+    return room.result;
 }
 
 int checkGameISReady(vector<Room> &rooms, int needed_room, int player_num, int choice)
@@ -325,6 +642,550 @@ int checkGameISReady(vector<Room> &rooms, int needed_room, int player_num, int c
     return all_playes_has_moved;
 }
 
+// Clears a judged room once its result has been broadcast and sends its
+// former players back to the room list.
+void finishGame(Server &server, int needed_room)
+{
+    const vector<RoomPlayer> &players = server.rooms[needed_room].players;
+    RoomPlayer former_room_players[MAX_CLIENTS];
+    copy(players.begin(), players.end(), former_room_players);
+
+    clearRoomSession(server, needed_room);
+
+    for (int k = 0; k < MAX_CLIENTS; k++)
+        sendRoomList(server, former_room_players[k]);
+}
+
+// Runs on the room's owner when both players have moved or the move deadline
+// expires; a player who has not answered by then played Move::NONE.
+void resolveGame(Server &server, int needed_room)
+{
+    Room &room = server.rooms[needed_room];
+    if (room.p1_choice == None)
+        room.p1_choice = static_cast<int>(Move::NONE);
+    if (room.p2_choice == None)
+        room.p2_choice = static_cast<int>(Move::NONE);
+    room.deadline = 0;
+    room.winner = judge(room.p1_choice, room.p2_choice);
+
+    const string &msg_to_send = examineGameResult(server, needed_room);
+
+    struct broadcast_info &bc_address = server.bc_address;
+    sendto(bc_address.sock, msg_to_send.data(), msg_to_send.size(),
+           0, (struct sockaddr *)&bc_address.bc_address, sizeof(bc_address.bc_address));
+
+    roomOwner(server, needed_room).timers.schedule(RESULT_DELAY_MS, [&server, needed_room]()
+                                                   { finishGame(server, needed_room); });
+}
+
+bool holdsSeat(const Room &room, int player_num, const RoomPlayer &player)
+{
+    if (player_num < PLAYER_1 || player_num > (int)room.players.size())
+        return false;
+    const RoomPlayer &seated = room.players[player_num - 1];
+    return seated.shard == player.shard && seated.fd == player.fd && seated.serial == player.serial;
+}
+
+// Runs on the room's owner. A move only counts while the room is waiting
+// for moves and when it comes from the connection that holds that player
+// number in the room.
+void receiveMove(Server &server, int needed_room, const RoomPlayer &sender, int player_num, int choice)
+{
+    vector<Room> &rooms = server.rooms;
+    if (!rooms[needed_room].asked_player2_choice || rooms[needed_room].winner != None)
+        return;
+    if (!holdsSeat(rooms[needed_room], player_num, sender))
+        return;
+
+    int all_playes_has_moved = checkGameISReady(rooms, needed_room, player_num, choice);
+
+    if (all_playes_has_moved)
+    {
+        roomOwner(server, needed_room).timers.cancel(rooms[needed_room].deadline);
+        resolveGame(server, needed_room);
+    }
+}
+
+// Runs on the room's owner when a player's connection closes. A player
+// waiting alone frees the room; one who leaves mid-game has played
+// Move::NONE unless they already moved, and the game goes on to its result.
+void leaveRoom(Server &server, int needed_room, const RoomPlayer &player)
+{
+    Room &room = server.rooms[needed_room];
+    int player_num = None;
+    for (int k = PLAYER_1; k <= (int)room.players.size(); k++)
+        if (holdsSeat(room, k, player))
+            player_num = k;
+    if (player_num == None || room.winner != None)
+        return;
+
+    if (!room.asked_player2_choice)
+    {
+        clearRoomSession(server, needed_room);
+        return;
+    }
+
+    int own_choice = player_num == PLAYER_1 ? room.p1_choice : room.p2_choice;
+    if (own_choice == None)
+        receiveMove(server, needed_room, player, player_num, static_cast<int>(Move::NONE));
+}
+
+void queueForMatch(Server &server, const RoomPlayer &player)
+{
+    server.match_queue.push(player);
+    wakeShard(*server.shards[0]);
+}
+
+// Runs on shard 0. The player was pushed on match_queue before it closed,
+// so the queue is drained first; a player already paired is past this and
+// gives its seat back from seatPlayer instead.
+void withdrawFromMatch(Server &server, const RoomPlayer &player)
+{
+    vector<RoomPlayer> &waiting = server.match_waiting;
+    RoomPlayer queued;
+    while (server.match_queue.pop(queued))
+        waiting.push_back(queued);
+
+    for (size_t k = 0; k < waiting.size(); k++)
+        if (waiting[k].shard == player.shard && waiting[k].fd == player.fd && waiting[k].serial == player.serial)
+        {
+            waiting.erase(waiting.begin() + k);
+            break;
+        }
+    server.match_pending = waiting.size() >= MAX_CLIENTS;
+}
+
+// Runs on shard 0. Takes an empty room out of the index for a pair; the
+// room's owner sets the bit again once the room empties after their game.
+// The search resumes where the last one stopped.
+int claimEmptyRoom(Server &server)
+{
+    int words = (server.rooms_number + ROOMS_PER_WORD - 1) / ROOMS_PER_WORD;
+    for (int k = 0; k < words; k++)
+    {
+        int w = (server.match_cursor + k) % words;
+        uint64_t empty_bits = server.empty_rooms[w].load();
+        if (empty_bits == 0)
+            continue;
+
+        int bit = __builtin_ctzll(empty_bits);
+        server.empty_rooms[w].fetch_and(~(1ull << bit));
+        server.match_cursor = w;
+        return w * ROOMS_PER_WORD + bit;
+    }
+    return None;
+}
+
+// Runs on the room's owner. A manual join may have taken the room since it
+// was claimed; the pair then goes back in the queue.
+void seatPair(Server &server, const Match &match)
+{
+    if (!server.rooms[match.room].players.empty())
+    {
+        for (const RoomPlayer &player : match.players)
+            queueForMatch(server, player);
+        return;
+    }
+
+    for (const RoomPlayer &player : match.players)
+        saveAndConnectToTheRoom(server, match.room, player);
+}
+
+// Runs on shard 0, the queue's only consumer. Everyone queued since the
+// last run is paired in arrival order, each pair into an empty room, and
+// every owner gets its pairs as one batch, so a burst of players costs each
+// owner a single wakeup. Players left over wait for the next run.
+void matchPlayers(Server &server)
+{
+    vector<RoomPlayer> &waiting = server.match_waiting;
+    RoomPlayer player;
+    while (server.match_queue.pop(player))
+        waiting.push_back(player);
+    if (waiting.size() < MAX_CLIENTS)
+        return;
+
+    // Raised before the search: an owner emptying a room after it has
+    // looked at that room's word then sees it and wakes shard 0 again.
+    server.match_pending = true;
+    vector<vector<Match>> batches(server.shards.size());
+    size_t paired = 0;
+    while (waiting.size() - paired >= MAX_CLIENTS)
+    {
+        int room = claimEmptyRoom(server);
+        if (room == None)
+            break;
+        Match match = {room, {waiting[paired], waiting[paired + 1]}};
+        batches[room % server.shards.size()].push_back(match);
+        paired += MAX_CLIENTS;
+    }
+    waiting.erase(waiting.begin(), waiting.begin() + paired);
+    server.match_pending = waiting.size() >= MAX_CLIENTS;
+
+    for (size_t i = 0; i < batches.size(); i++)
+    {
+        if (batches[i].empty())
+            continue;
+        vector<Match> batch;
+        batch.swap(batches[i]);
+        runOn(*server.shards[i], [&server, batch]()
+              {
+                  for (const Match &match : batch)
+                      seatPair(server, match); });
+    }
+}
+
+// Payloads that fail to parse are dropped. Moves are routed by the
+// connection's session and only accepted for the seat it holds. A player
+// who has asked for a room or a match, or holds a seat, cannot rename
+// itself or ask for another until the game is over and the room list has
+// been sent back.
+void handleFrame(Shard &shard, int i, const Frame &frame)
+{
+    Server &server = *shard.server;
+    PayloadReader payload(frame);
+
+    // The broadcast socket has no session and only carries announcements.
+    if (i == server.bc_address.sock)
+    {
+        if (frame.opcode == Opcode::JUDGE_RESULT || frame.opcode == Opcode::FINAL)
+        {
+            logMsg(payload.rest().c_str());
+            if (frame.opcode == Opcode::FINAL)
+                exit(EXIT_SUCCESS);
+        }
+        return;
+    }
+
+    if (frame.opcode == Opcode::NAME)
+    {
+        Session &session = shard.sessions[i];
+        if (session.matchmaking || session.room != None)
+            return;
+        session.player = server.players.intern(payload.rest());
+        if (session.player == None)
+        {
+            closeClient(shard, i);
+            return;
+        }
+        server.players[session.player].wins = 0;
+        enterLobby(shard, i);
+        sendFrame(shard, i, generateRoomList(shard));
+    }
+
+    else if (frame.opcode == Opcode::MATCHMAKE)
+    {
+        Session &session = shard.sessions[i];
+        if (session.player == None)
+            sendFrame(shard, i, encodeFrame(Opcode::NAME_PROMPT));
+        else if (!session.matchmaking && session.room == None)
+        {
+            session.matchmaking = true;
+            leaveLobby(shard, i);
+            queueForMatch(server, RoomPlayer{shard.id, i, session.serial, session.player});
+        }
+    }
+
+    else if (frame.opcode == Opcode::ROOM_CHOICE)
+    {
+        Session &session = shard.sessions[i];
+        int current_room = (int)payload.u32() - 1;
+        if (session.matchmaking || session.room != None)
+            return;
+        if (session.player == None)
+            sendFrame(shard, i, encodeFrame(Opcode::NAME_PROMPT));
+        else if (!payload.ok() || current_room < 0 || current_room >= server.rooms_number)
+            sendFrame(shard, i, unavailableRoomList(shard));
+        else
+        {
+            session.room = current_room;
+            RoomPlayer player = {shard.id, i, session.serial, session.player};
+            runOn(roomOwner(server, current_room), [&server, current_room, player]()
+                  { saveAndConnectToTheRoom(server, current_room, player); });
+        }
+    }
+
+    else if (frame.opcode == Opcode::MOVE)
+    {
+        const Session &session = shard.sessions[i];
+        int needed_room = (int)payload.u32() - 1;
+        int player_num = payload.u8();
+        int choice = payload.u8();
+        RoomPlayer player = {shard.id, i, session.serial, session.player};
+
+        if (payload.ok() && needed_room == session.room && player_num == session.player_number)
+            runOn(roomOwner(server, needed_room), [&server, needed_room, player, player_num, choice]()
+                  { receiveMove(server, needed_room, player, player_num, choice); });
+    }
+}
+
+// Reads everything a player connection has queued and handles each whole
+// frame in it; partial frames wait in the connection's buffer for the rest.
+// A corrupt stream closes the connection.
+//
+// Outgoing frames are queued and written together with writev once the
+// current batch of events is handled. When the socket is full the rest of
+// the queue waits for EPOLLOUT; a player whose backlog behind the frame
+// being written grows past MAX_QUEUED_BYTES is not reading and is
+// disconnected. The limit leaves room for one frame of the largest size, so
+// a full room list never counts against a player on its own.
+class ClientHandler : public EventHandler
+{
+public:
+    ClientHandler(Shard &shard, int fd)
+        : shard(shard), fd(fd), queued_bytes(0), sent_offset(0), flush_requested(false), blocked(false) {}
+
+    void enqueue(const string &frame)
+    {
+        size_t in_flight = outbound.empty() ? 0 : outbound.front().size() - sent_offset;
+        if (queued_bytes - in_flight + frame.size() > MAX_QUEUED_BYTES)
+        {
+            closeClient(shard, fd);
+            return;
+        }
+
+        outbound.push_back(frame);
+        queued_bytes += frame.size();
+        if (!flush_requested && !blocked)
+        {
+            flush_requested = true;
+            shard.reactor.flushAfterBatch(fd);
+        }
+    }
+
+    void flush() override
+    {
+        flush_requested = false;
+        while (!outbound.empty())
+        {
+            struct iovec iov[MAX_IOVECS];
+            int count = 0;
+            size_t offset = sent_offset;
+            for (auto it = outbound.begin(); it != outbound.end() && count < MAX_IOVECS; ++it, ++count)
+            {
+                iov[count].iov_base = (char *)it->data() + offset;
+                iov[count].iov_len = it->size() - offset;
+                offset = 0;
+            }
+
+            ssize_t written = writev(fd, iov, count);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                blocked = true;
+                return;
+            }
+            if (written < 0)
+            {
+                closeClient(shard, fd);
+                return;
+            }
+            consume(written);
+        }
+        blocked = false;
+    }
+
+    void handleEvent(uint32_t events) override
+    {
+        if ((events & EPOLLOUT) && blocked)
+            flush();
+
+        while (shard.reactor.handler(fd) == this)
+        {
+            ssize_t received = recv(fd, shard.buffer, BUFFER_SIZE, 0);
+            if (received > 0)
+                handleFrames(received);
+            else if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                closeClient(shard, fd);
+            else if (errno != EINTR)
+                break;
+        }
+    }
+
+private:
+    void handleFrames(size_t received)
+    {
+        frames.append(shard.buffer, received);
+        Frame frame;
+        while (shard.reactor.handler(fd) == this && frames.next(frame))
+            handleFrame(shard, fd, frame);
+        if (frames.corrupt())
+            closeClient(shard, fd);
+    }
+
+    void consume(size_t written)
+    {
+        queued_bytes -= written;
+        written += sent_offset;
+        while (!outbound.empty() && written >= outbound.front().size())
+        {
+            written -= outbound.front().size();
+            outbound.pop_front();
+        }
+        sent_offset = written;
+    }
+
+    Shard &shard;
+    int fd;
+    FrameBuffer frames;
+    deque<string> outbound;
+    size_t queued_bytes;
+    size_t sent_offset;
+    bool flush_requested;
+    bool blocked;
+};
+
+// Frames for a connection that has since closed are dropped.
+void sendFrame(Shard &shard, int fd, const string &frame)
+{
+    ClientHandler *client = dynamic_cast<ClientHandler *>(shard.reactor.handler(fd));
+    if (client)
+        client->enqueue(frame);
+}
+
+void registerClient(Shard &shard, int client_fd)
+{
+    setNonBlocking(client_fd);
+    if (!shard.reactor.add(client_fd, new ClientHandler(shard, client_fd), EPOLLIN | EPOLLOUT | EPOLLET))
+    {
+        close(client_fd);
+        return;
+    }
+
+    if ((size_t)client_fd >= shard.sessions.size())
+        shard.sessions.resize(client_fd + 1);
+    shard.sessions[client_fd] = Session();
+    shard.sessions[client_fd].serial = ++shard.next_serial;
+}
+
+class ListenHandler : public EventHandler
+{
+public:
+    ListenHandler(Shard &shard, int listen_fd) : shard(shard), listen_fd(listen_fd) {}
+
+    void handleEvent(uint32_t events) override
+    {
+        while (1)
+        {
+            int new_socket = acceptClient(listen_fd);
+            if (new_socket < 0 && (errno == EINTR || errno == ECONNABORTED))
+                continue;
+            if (new_socket < 0)
+                break;
+
+            registerClient(shard, new_socket);
+            sendFrame(shard, new_socket, encodeFrame(Opcode::NAME_PROMPT));
+        }
+    }
+
+private:
+    Shard &shard;
+    int listen_fd;
+};
+
+class TimerHandler : public EventHandler
+{
+public:
+    explicit TimerHandler(Shard &shard) : shard(shard) {}
+
+    void handleEvent(uint32_t events) override
+    {
+        shard.timers.expire();
+    }
+
+private:
+    Shard &shard;
+};
+
+// Runs the tasks posted to the shard, then tells its lobby about the rooms
+// those tasks reported as filled up or freed. Shard 0 also pairs the
+// players waiting for a match here.
+class InboxHandler : public EventHandler
+{
+public:
+    explicit InboxHandler(Shard &shard) : shard(shard) {}
+
+    void handleEvent(uint32_t events) override
+    {
+        uint64_t wakeups;
+        read(shard.wake_fd, &wakeups, sizeof(wakeups));
+        shard.wake_pending = false;
+
+        function<void()> task;
+        while (shard.inbox.pop(task))
+            task();
+        if (shard.id == 0)
+            matchPlayers(*shard.server);
+        if (!shard.room_updates.empty())
+            publishRoomUpdates(shard);
+    }
+
+private:
+    Shard &shard;
+};
+
+class BroadcastHandler : public EventHandler
+{
+public:
+    explicit BroadcastHandler(Shard &shard) : shard(shard), datagram(DATAGRAM_SIZE) {}
+
+    void handleEvent(uint32_t events) override
+    {
+        while (1)
+        {
+            ssize_t received = recv(shard.server->bc_address.sock, datagram.data(), datagram.size(), 0);
+            if (received < 0)
+                break;
+
+            Frame frame;
+            if (decodeFrame(datagram.data(), received, frame))
+                handleFrame(shard, shard.server->bc_address.sock, frame);
+        }
+    }
+
+private:
+    Shard &shard;
+    vector<char> datagram;
+};
+
+// stdin is shared with the terminal, so it stays blocking and is registered
+// level-triggered: each wakeup reads one command line.
+class StdinHandler : public EventHandler
+{
+public:
+    explicit StdinHandler(Shard &shard) : shard(shard) {}
+
+    void handleEvent(uint32_t events) override
+    {
+        memset(shard.buffer, 0, BUFFER_SIZE);
+        if (read(STDIN_FILENO, shard.buffer, BUFFER_SIZE - 1) <= 0)
+        {
+            shard.reactor.remove(STDIN_FILENO);
+            return;
+        }
+        terminateGame(shard.buffer, *shard.server);
+    }
+
+private:
+    Shard &shard;
+};
+
+// Every shard listens on the lobby port through its own SO_REUSEPORT socket,
+// so the kernel spreads incoming players across the reactor threads.
+Shard *setupShard(Server &server, int id, const char *ip)
+{
+    Shard *shard = new Shard;
+    shard->id = id;
+    shard->server = &server;
+    shard->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    shard->reactor.add(shard->wake_fd, new InboxHandler(*shard));
+    shard->reactor.add(shard->timers.fd(), new TimerHandler(*shard));
+
+    int lobby_socket = setupServer(server.port, ip, true);
+    shard->reactor.add(lobby_socket, new ListenHandler(*shard, lobby_socket));
+    return shard;
+}
+
 int main(int argc, char const *argv[])
 {
     if (argc != NUM_SERVER_INPUTS)
@@ -333,128 +1194,47 @@ int main(int argc, char const *argv[])
         exit(EXIT_FAILURE);
     }
     const char *ip = argv[1];
-    int port = atoi(argv[2]);
-    int rooms_number = atoi(argv[3]);
+    Server server;
+    server.port = atoi(argv[2]);
+    server.rooms_number = atoi(argv[3]);
+    if (server.rooms_number < 1 || server.rooms_number > MAX_ROOMS)
+    {
+        logError(ROOMS_NUMBER_ERROR.c_str());
+        exit(EXIT_FAILURE);
+    }
 
-    int server_socket = setupServer(port, ip);
-    struct broadcast_info bc_address = connectBroadcastSocket();
+    checkPortIsFree(server.port, ip);
+    int shards_number = max(1u, thread::hardware_concurrency());
+    for (int i = 0; i < shards_number; i++)
+        server.shards.emplace_back(setupShard(server, i, ip));
+    server.bc_address = connectBroadcastSocket();
     logInfo(CONNECTION_ENABLED.c_str());
 
-    vector<struct Room> rooms = setupRooms(port, ip, rooms_number);
-
-    int max_sd;
-    fd_set master_set, working_set;
-    intiFileDescriptorSet(server_socket, master_set, max_sd, rooms_number, rooms, bc_address);
+    server.rooms = setupRooms(server.rooms_number);
+    server.free_rooms.reset(new atomic<uint64_t>[(server.rooms_number + ROOMS_PER_WORD - 1) / ROOMS_PER_WORD]());
+    server.empty_rooms.reset(new atomic<uint64_t>[(server.rooms_number + ROOMS_PER_WORD - 1) / ROOMS_PER_WORD]());
+    for (int i = 0; i < server.rooms_number; i++)
+    {
+        server.free_rooms[i / ROOMS_PER_WORD] |= 1ull << (i % ROOMS_PER_WORD);
+        server.empty_rooms[i / ROOMS_PER_WORD] |= 1ull << (i % ROOMS_PER_WORD);
+    }
 
-    map<string, int> players_win_count;
-    map<int, string> players_names;
-    char buffer[BUFFER_SIZE] = {0};
-    int new_socket;
+    Shard &main_shard = *server.shards[0];
+    main_shard.reactor.add(server.bc_address.sock, new BroadcastHandler(main_shard));
+    main_shard.reactor.add(STDIN_FILENO, new StdinHandler(main_shard), EPOLLIN);
 
     signal(SIGINT, signalHandler);
-    while (1)
-    {
-        working_set = master_set;
-        select(max_sd + 1, &working_set, NULL, NULL, NULL);
+    signal(SIGPIPE, SIG_IGN);
 
-        for (int i = 0; i <= max_sd; i++)
-        {
-            if (FD_ISSET(i, &working_set))
-            {
-                if (i == STDIN_FILENO)
-                    terminateGame(buffer, players_win_count, bc_address);
-
-                int current_room = getRoomNumber(rooms_number, i, rooms);
-                if (i == server_socket)
-                {
-                    new_socket = acceptClient(server_socket);
-                    FD_SET(new_socket, &master_set);
-                    if (new_socket > max_sd)
-                        max_sd = new_socket;
-                    send(new_socket, RECEIVE_NAME_MESSAGE, strlen(RECEIVE_NAME_MESSAGE), 0);
-                }
-                else if (current_room != ROOM_NOT_FOUND)
-                {
-                    new_socket = acceptClient(rooms[current_room].room_socket);
-                    FD_SET(new_socket, &master_set);
-                    if (new_socket > max_sd)
-                        max_sd = new_socket;
-
-                    askPlayersToMove(rooms, current_room, new_socket);
-                }
-                else
-                {
-                    recv(i, buffer, BUFFER_SIZE, 0);
-                    string new_message(buffer), pattern, message;
-
-                    pair<string, string> info = extractPatternAndMessage(new_message);
-                    pattern = info.first;
-                    message = info.second;
-
-                    if (pattern == NAME_INP_OPC)
-                    {
-                        message.pop_back();
-                        players_names[i] = message;
-                        players_win_count[message] = 0;
-                        string msg_to_send = RECEIVE_ROOM_NUMBER_MESSAGE + generateRoomList(rooms_number, rooms);
-                        send(i, msg_to_send.c_str(), strlen(msg_to_send.c_str()), 0);
-                    }
-
-                    else if (pattern == ROOM_CHOOSE_OPC)
-                    {
-                        int current_room = stoi(message) - 1;
-                        saveAndConnectToTheRoom(rooms, current_room, rooms_number, port, i);
-                    }
-
-                    else if (pattern == ENCODED_CHOICE_OPC)
-                    {
-                        vector<string> info = extractInfo(message);
-                        int room_num = stoi(info[0]);
-                        int player_num = stoi(info[1]);
-                        int choice = stoi(info[2]);
-
-                        int all_playes_has_moved = 0, needed_room = room_num - 1;
-
-                        all_playes_has_moved = checkGameISReady(rooms, needed_room, player_num, choice);
-
-                        if (all_playes_has_moved)
-                        {
-                            rooms[needed_room].winner = judge(rooms[needed_room].p1_choice, rooms[needed_room].p2_choice);
-
-                            string msg_to_send = examineGameResult(rooms, players_names, players_win_count, needed_room);
-
-                            sendto(bc_address.sock, msg_to_send.c_str(), strlen(msg_to_send.c_str()),
-                                   0, (struct sockaddr *)&bc_address.bc_address, sizeof(bc_address.bc_address));
-
-                            this_thread::sleep_for(chrono::milliseconds(TIME_OUT));
-
-                            clearRoomSession(rooms, needed_room, master_set);
-
-                            vector<int> former_room_players;
-
-                            for (int k = 0; k < 2; k++)
-                                former_room_players.push_back(rooms[needed_room].players[k]);
-
-                            for (int k = 0; k < 2; k++)
-                            {
-                                string new_msg_to_send = RECEIVE_ROOM_NUMBER_MESSAGE + generateRoomList(rooms_number, rooms);
-                                send(former_room_players[k], new_msg_to_send.c_str(), strlen(new_msg_to_send.c_str()), 0);
-                            }
-                        }
-                    }
-
-                    else if (pattern == JUDGE_RESULT_OPC || pattern == FINAL_MSG_OPC)
-                    {
-                        logMsg(message.c_str());
-                        if (pattern == FINAL_MSG_OPC)
-                            exit(EXIT_SUCCESS);
-                    }
-
-                    memset(buffer, 0, BUFFER_SIZE);
-                }
-            }
-        }
+    vector<thread> reactor_threads;
+    for (int i = 1; i < shards_number; i++)
+    {
+        Shard *shard = server.shards[i].get();
+        reactor_threads.emplace_back([shard]()
+                                     { current_shard = shard; shard->reactor.run(); });
     }
+    current_shard = &main_shard;
+    main_shard.reactor.run();
 
     return 0;
-}
\ No newline at end of file
+}
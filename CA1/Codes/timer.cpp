@@ -0,0 +1,180 @@
+#include "timer.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+
+#include "logger.h"
+
+const uint64_t SLOT_MASK = TIMER_SLOTS - 1;
+const uint64_t MAX_DELAY_TICKS = (1ull << (TIMER_SLOT_BITS * TIMER_LEVELS)) - 1;
+
+static uint64_t monotonicMs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+TimerWheel::TimerWheel() : start_ms(monotonicMs()), current(0), pending(0)
+{
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0)
+    {
+        logError("Timer creation failed.");
+        exit(EXIT_FAILURE);
+    }
+}
+
+TimerWheel::~TimerWheel()
+{
+    close(timer_fd);
+}
+
+int TimerWheel::fd() const
+{
+    return timer_fd;
+}
+
+uint64_t TimerWheel::elapsedTicks() const
+{
+    return (monotonicMs() - start_ms) / TIMER_TICK_MS;
+}
+
+void TimerWheel::arm(bool ticking)
+{
+    struct itimerspec spec = {};
+    if (ticking)
+    {
+        spec.it_interval.tv_nsec = TIMER_TICK_MS * 1000000L;
+        spec.it_value = spec.it_interval;
+    }
+    timerfd_settime(timer_fd, 0, &spec, nullptr);
+}
+
+bool TimerWheel::isPending(TimerId id) const
+{
+    uint32_t entry = id >> 32;
+    return entry < live.size() && live[entry] && generations[entry] == (uint32_t)id;
+}
+
+void TimerWheel::release(TimerId id)
+{
+    uint32_t entry = id >> 32;
+    live[entry] = false;
+    generations[entry]++;
+    free_entries.push_back(entry);
+    pending--;
+}
+
+// A timer lands on the lowest level whose span covers its distance from the
+// current tick; its slot is picked by the expiry bits of that level.
+void TimerWheel::insert(Timer timer)
+{
+    if (timer.expires < current)
+        timer.expires = current;
+    uint64_t delta = timer.expires - current;
+    if (delta > MAX_DELAY_TICKS)
+    {
+        timer.expires = current + MAX_DELAY_TICKS;
+        delta = MAX_DELAY_TICKS;
+    }
+
+    int level = 0;
+    while (level < TIMER_LEVELS - 1 && delta >> (TIMER_SLOT_BITS * (level + 1)))
+        level++;
+    size_t slot = (timer.expires >> (TIMER_SLOT_BITS * level)) & SLOT_MASK;
+    slots[level][slot].push_back(move(timer));
+}
+
+// Emptied slots are swapped with the scratch vector rather than moved out,
+// so their capacity stays with the wheel.
+void TimerWheel::cascade(int level, size_t slot)
+{
+    scratch.swap(slots[level][slot]);
+    for (Timer &timer : scratch)
+        if (isPending(timer.id))
+            insert(move(timer));
+    scratch.clear();
+}
+
+// The tick counter moves on before callbacks run, so a callback scheduling
+// another timer never lands in the slot being emptied.
+void TimerWheel::tick()
+{
+    size_t index = current & SLOT_MASK;
+    for (int level = 1; index == 0 && level < TIMER_LEVELS; level++)
+    {
+        index = (current >> (TIMER_SLOT_BITS * level)) & SLOT_MASK;
+        cascade(level, index);
+    }
+
+    scratch.swap(slots[0][current & SLOT_MASK]);
+    current++;
+    for (Timer &timer : scratch)
+    {
+        if (!isPending(timer.id))
+            continue;
+        release(timer.id);
+        timer.callback();
+    }
+    scratch.clear();
+}
+
+// An idle wheel skips straight to the present, so the ticks it slept
+// through are never replayed.
+TimerId TimerWheel::schedule(int delay_ms, function<void()> callback)
+{
+    uint64_t now = elapsedTicks();
+    if (pending == 0)
+    {
+        if (now > current)
+            current = now;
+        arm(true);
+    }
+
+    uint32_t entry;
+    if (free_entries.empty())
+    {
+        entry = live.size();
+        live.push_back(false);
+        generations.push_back(1);
+    }
+    else
+    {
+        entry = free_entries.back();
+        free_entries.pop_back();
+    }
+    live[entry] = true;
+    pending++;
+
+    uint64_t ticks = (delay_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    TimerId id = (TimerId)entry << 32 | generations[entry];
+    insert(Timer{id, max(now, current) + ticks, move(callback)});
+    return id;
+}
+
+// Cancelled timers stay in their slot and are dropped when it comes up.
+void TimerWheel::cancel(TimerId id)
+{
+    if (!isPending(id))
+        return;
+    release(id);
+    if (pending == 0)
+        arm(false);
+}
+
+// Catches up on every tick that has elapsed, however many timerfd
+// expirations were coalesced into this wakeup.
+void TimerWheel::expire()
+{
+    uint64_t expirations;
+    read(timer_fd, &expirations, sizeof(expirations));
+
+    uint64_t now = elapsedTicks();
+    while (current <= now && pending > 0)
+        tick();
+    if (pending == 0)
+        arm(false);
+}
@@ -0,0 +1,67 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+typedef uint64_t TimerId;
+
+const int TIMER_TICK_MS = 10;
+const int TIMER_LEVELS = 4;
+const int TIMER_SLOT_BITS = 6;
+const int TIMER_SLOTS = 1 << TIMER_SLOT_BITS;
+
+// Hierarchical timer wheel driven by a timerfd. Level 0 has one slot per
+// tick; each higher level has one slot per full turn of the level below and
+// is cascaded down when that turn completes, so scheduling, cancelling and
+// expiring a timer cost O(1) however many are pending. A timer id names a
+// reusable entry in a table and that entry's generation, so ids of fired or
+// cancelled timers go stale and a busy wheel stops allocating once its
+// slots and table have grown. The timerfd only ticks while timers are
+// pending. Not thread-safe: a wheel belongs to the reactor thread that
+// registers fd() and calls expire() when it is readable.
+class TimerWheel
+{
+public:
+    TimerWheel();
+    ~TimerWheel();
+
+    TimerId schedule(int delay_ms, function<void()> callback);
+    void cancel(TimerId id);
+    void expire();
+    int fd() const;
+
+private:
+    struct Timer
+    {
+        TimerId id;
+        uint64_t expires;
+        function<void()> callback;
+    };
+
+    TimerWheel(const TimerWheel &);
+    TimerWheel &operator=(const TimerWheel &);
+
+    uint64_t elapsedTicks() const;
+    void arm(bool ticking);
+    bool isPending(TimerId id) const;
+    void release(TimerId id);
+    void insert(Timer timer);
+    void cascade(int level, size_t slot);
+    void tick();
+
+    int timer_fd;
+    uint64_t start_ms;
+    uint64_t current;
+    size_t pending;
+    vector<uint32_t> generations;
+    vector<bool> live;
+    vector<uint32_t> free_entries;
+    vector<Timer> slots[TIMER_LEVELS][TIMER_SLOTS];
+    vector<Timer> scratch;
+};
+
+#endif
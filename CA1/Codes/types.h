@@ -19,21 +19,31 @@
 #include <sstream>
 
 #include <string>
+#include "protocol.h"
+#include "timer.h"
 using namespace std;
 
-const int BACKLOG = 5;
+const int BACKLOG = 128;
 const int BUFFER_SIZE = 1024;
+const int DATAGRAM_SIZE = 65536;
+const int MAX_IOVECS = 64;
+const size_t MAX_QUEUED_BYTES = FRAME_HEADER_SIZE + MAX_FRAME_PAYLOAD;
+const int PLAYER_CHUNK_SIZE = 1024;
+const int MAX_PLAYER_CHUNKS = 4096;
+const int ROOMS_PER_WORD = 64;
+const int MAX_ROOMS = MAX_FRAME_PAYLOAD / sizeof(uint32_t);
 const int BROADCAST_PORT = 9090;
 const int NUM_CLIENT_INPUTS = 3;
 const int NUM_SERVER_INPUTS = 4;
 const int TIME_OUT = 10;
+const int MOVE_TIMEOUT_MS = TIME_OUT * 1000;
+const int RESULT_DELAY_MS = 10;
 const int FAILED = -1;
 const int ROOM_NOT_FOUND = -1;
 int None = -1;
 const int PLAYER_1 = 1;
 const int PLAYER_2 = 2;
 const int DRAW = 0;
-int TIME_OVER = 0;
 const int MAX_CLIENTS =2;
 
 const string CONNECTION_ENABLED = "Connection enabeled.";
@@ -43,31 +53,24 @@ const string BIND_FAILED = "Bind failed.";
 const string LISTEN_FAILED = "Listen failed.";
 const string CONNECTION_FAILED = "Connection failed.";
 const string CLIENT_CONNECTED = "Client connected.";
+const string SERVER_CLOSED = "Connection closed by server.";
 const string SERVER_INPUT_ERROR = "Usage: ./server.out {IP} {Port} {Number of rooms}";
 const string CLIENT_INPUT_ERROR = "Usage: ./server.out {IP} {Port}";
+const string ROOMS_NUMBER_ERROR = "Number of rooms must be between 1 and " + to_string(MAX_ROOMS) + ".";
 
-const string STAR = "*";
-const string NO_READ = "---";
 const string END_GAME_COMMAND = "end_game";
 const string BROADCAST_IP = "127.255.255.255";
 
-const char *RECEIVE_NAME_MESSAGE = "*!!!*Please enter your name:";
-const char *RECEIVE_ROOM_NUMBER_MESSAGE = "*@@@*These are available rooms. Please select one of them and enter it's number:";
-const char *ROOM_UNAVAILABLE_MESSAGE = "*@@@*This room is not available right now. Please try again.";
-const char *FIRST_PLAYER_MESSAGE = "*$$$*Game will start soon! Please wait...";
-const char *SECOND_PLAYER_MESSAGE = "*^^^*Let's start!";
-const char *CHOOSE_MOVE_MESSAGE = "*&&&*Choose between\n1)rock\n2)paper\n3)scissors";
-const char *END_GAME_MESSAGE = "*(((*The game ended. Here is the list of players and win counts:\n";
-
-const string NAME_INP_OPC = "!!!";
-const string ROOM_CHOOSE_OPC = "@@@";
-const string CONNECT_WITH_ROOM_OPC = ")))";
-const string PLAYER1_OPC = "$$$";
-const string PLAYER2_OPC = "^^^";
-const string GAME_BEGIN_OPC = "&&&";
-const string ENCODED_CHOICE_OPC = "===";
-const string JUDGE_RESULT_OPC = "+++";
-const string FINAL_MSG_OPC = "(((";
+const char *RECEIVE_NAME_MESSAGE = "Please enter your name:";
+const char *RECEIVE_ROOM_NUMBER_MESSAGE = "These are available rooms. Please select one of them and enter it's number, or enter 0 to play the next waiting player:";
+const char *ROOM_UNAVAILABLE_MESSAGE = "This room is not available right now. Please try again.";
+const char *MATCHMAKING_MESSAGE = "Looking for an opponent...";
+const char *FIRST_PLAYER_MESSAGE = "Game will start soon! Please wait...";
+const char *SECOND_PLAYER_MESSAGE = "Let's start!";
+const char *CHOOSE_MOVE_MESSAGE = "Choose between\n1)rock\n2)paper\n3)scissors";
+const char *END_GAME_MESSAGE = "The game ended. Here is the list of players and win counts:\n";
+const char *ROOM_FULL_MESSAGE = " is full now.";
+const char *ROOM_FREE_MESSAGE = " has a free seat now.";
 
 enum class Move {
 
@@ -83,18 +86,59 @@ struct broadcast_info
     struct sockaddr_in bc_address;
 };
 
+struct ClientState
+{
+    int server_socket;
+    Opcode read_state;
+    int player_number;
+    int room_number;
+};
+
+// A lobby connection on the server, indexed by its fd in its shard. serial
+// tells a connection apart from a later one that reuses the fd; room is the
+// index of the room it has asked to join or sits in, until it is sent the
+// room list again; player is the interned player id.
+// lobby_index is its place in the shard's lobby while it is choosing a room;
+// matchmaking is set from asking to be matched until it is seated.
+struct Session
+{
+    uint32_t serial = 0;
+    int player = None;
+    int room = None;
+    int player_number = None;
+    int lobby_index = None;
+    bool matchmaking = false;
+};
+
+struct RoomPlayer
+{
+    int shard;
+    int fd;
+    uint32_t serial;
+    int player;
+};
+
+struct Match
+{
+    int room;
+    RoomPlayer players[MAX_CLIENTS];
+};
+
+// win_result and tie_result are the room's announcements, formatted once;
+// result is the buffer a win is announced from.
 struct Room
 {
-    int room_socket;
     int room_number;
-    int player_1;
-    int player_2;
-    vector<int> players;
+    vector<RoomPlayer> players;
     bool asked_player1_choice = false;
     bool asked_player2_choice = false;
     int p1_choice = None;
     int p2_choice = None;
     int winner = None;
+    TimerId deadline = 0;
+    string win_result;
+    string tie_result;
+    string result;
 };
 
 
@@ -0,0 +1,93 @@
+#include "checkpoint.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+static const char CHECKPOINT_MAGIC[4] = {'V', 'F', 'C', 'K'};
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+static void writeHistory(ofstream &out, const vector<float> &history)
+{
+     uint32_t length = history.size();
+     out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+     out.write(reinterpret_cast<const char *>(history.data()), length * sizeof(float));
+}
+
+static bool readHistory(ifstream &in, vector<float> &history)
+{
+     uint32_t length = 0;
+     if (!in.read(reinterpret_cast<char *>(&length), sizeof(length)))
+          return false;
+
+     history.resize(length);
+     return static_cast<bool>(in.read(reinterpret_cast<char *>(history.data()), length * sizeof(float)));
+}
+
+bool loadCheckpoint(const string &checkpointFile, FilterCheckpoint &checkpoint)
+{
+     ifstream in(checkpointFile, ios::binary);
+     if (!in)
+          return false;
+
+     char magic[4];
+     uint32_t version = 0;
+     uint64_t processedFrames = 0;
+     int32_t channels = 0, samplerate = 0;
+
+     in.read(magic, sizeof(magic));
+     in.read(reinterpret_cast<char *>(&version), sizeof(version));
+     in.read(reinterpret_cast<char *>(&processedFrames), sizeof(processedFrames));
+     in.read(reinterpret_cast<char *>(&channels), sizeof(channels));
+     in.read(reinterpret_cast<char *>(&samplerate), sizeof(samplerate));
+
+     if (!in || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 || version != CHECKPOINT_VERSION ||
+         !readHistory(in, checkpoint.firHistory) ||
+         !readHistory(in, checkpoint.iirInputHistory) ||
+         !readHistory(in, checkpoint.iirOutputHistory))
+     {
+          cerr << "Error reading checkpoint file: " << checkpointFile << endl;
+          exit(1);
+     }
+
+     checkpoint.processedFrames = processedFrames;
+     checkpoint.channels = channels;
+     checkpoint.samplerate = samplerate;
+     return true;
+}
+
+void saveCheckpoint(const string &checkpointFile, const FilterCheckpoint &checkpoint)
+{
+     string tempFile = checkpointFile + ".tmp";
+     ofstream out(tempFile, ios::binary | ios::trunc);
+     if (!out)
+     {
+          cerr << "Error opening checkpoint file: " << tempFile << endl;
+          exit(1);
+     }
+
+     uint64_t processedFrames = checkpoint.processedFrames;
+     int32_t channels = checkpoint.channels, samplerate = checkpoint.samplerate;
+
+     out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+     out.write(reinterpret_cast<const char *>(&CHECKPOINT_VERSION), sizeof(CHECKPOINT_VERSION));
+     out.write(reinterpret_cast<const char *>(&processedFrames), sizeof(processedFrames));
+     out.write(reinterpret_cast<const char *>(&channels), sizeof(channels));
+     out.write(reinterpret_cast<const char *>(&samplerate), sizeof(samplerate));
+     writeHistory(out, checkpoint.firHistory);
+     writeHistory(out, checkpoint.iirInputHistory);
+     writeHistory(out, checkpoint.iirOutputHistory);
+     out.close();
+
+     // The outputs have already been extended at this point, so the rename
+     // must be atomic: a torn checkpoint would replay or skip frames.
+     if (!out || rename(tempFile.c_str(), checkpointFile.c_str()) != 0)
+     {
+          cerr << "Error writing checkpoint file: " << checkpointFile << endl;
+          exit(1);
+     }
+}
@@ -0,0 +1,12 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include "types.h"
+
+using namespace std;
+
+bool loadCheckpoint(const string &checkpointFile, FilterCheckpoint &checkpoint);
+void saveCheckpoint(const string &checkpointFile, const FilterCheckpoint &checkpoint);
+
+#endif
@@ -0,0 +1,298 @@
+#include "daemon.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <chrono>
+#include <csignal>
+#include <cerrno>
+#include <cstdint>
+#include <pthread.h>
+#include <sndfile.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "types.h"
+#include "filters.h"
+#include "threadpool.h"
+
+using namespace std;
+
+static const int DAEMON_BACKLOG = 16;
+static const size_t DAEMON_BUFFER_SIZE = 4096;
+static const size_t DAEMON_MAX_REQUEST = 16384;
+static const useconds_t DAEMON_ACCEPT_BACKOFF_US = 100000;
+static const char SHARED_AUDIO_MAGIC[4] = {'V', 'F', 'S', 'A'};
+static const string SHARED_MEMORY_PREFIX = "shm:";
+
+static long long elapsedMicroseconds(chrono::high_resolution_clock::time_point since)
+{
+     return chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now() - since).count();
+}
+
+static bool isSharedMemory(const string &location)
+{
+     return location.compare(0, SHARED_MEMORY_PREFIX.size(), SHARED_MEMORY_PREFIX) == 0;
+}
+
+static bool readSharedAudio(const string &name, vector<float> &data, SF_INFO &fileInfo)
+{
+     int fd = shm_open(name.c_str(), O_RDONLY, 0);
+     if (fd < 0)
+          return false;
+
+     struct stat status;
+     if (fstat(fd, &status) < 0 || static_cast<size_t>(status.st_size) < sizeof(SharedAudioHeader))
+     {
+          close(fd);
+          return false;
+     }
+
+     void *mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+     close(fd);
+     if (mapping == MAP_FAILED)
+          return false;
+
+     // frames and channels come from the client, so they are checked against
+     // the mapping before they are multiplied.
+     const SharedAudioHeader *header = static_cast<const SharedAudioHeader *>(mapping);
+     size_t capacity = (status.st_size - sizeof(SharedAudioHeader)) / sizeof(float);
+     bool valid = memcmp(header->magic, SHARED_AUDIO_MAGIC, sizeof(SHARED_AUDIO_MAGIC)) == 0 &&
+                  header->channels > 0 && header->frames >= 0 &&
+                  static_cast<uint64_t>(header->frames) <= capacity / header->channels;
+     if (valid)
+     {
+          size_t samples = static_cast<size_t>(header->frames) * header->channels;
+          const float *audio = reinterpret_cast<const float *>(header + 1);
+          data.assign(audio, audio + samples);
+          fileInfo.frames = header->frames;
+          fileInfo.channels = header->channels;
+          fileInfo.samplerate = header->samplerate;
+          fileInfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+     }
+
+     munmap(mapping, status.st_size);
+     return valid;
+}
+
+static bool writeSharedAudio(const string &name, const vector<float> &data, const SF_INFO &fileInfo)
+{
+     int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+     if (fd < 0)
+          return false;
+
+     size_t size = sizeof(SharedAudioHeader) + data.size() * sizeof(float);
+     if (ftruncate(fd, size) < 0)
+     {
+          close(fd);
+          return false;
+     }
+
+     void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+     close(fd);
+     if (mapping == MAP_FAILED)
+          return false;
+
+     SharedAudioHeader *header = static_cast<SharedAudioHeader *>(mapping);
+     memcpy(header->magic, SHARED_AUDIO_MAGIC, sizeof(SHARED_AUDIO_MAGIC));
+     header->channels = fileInfo.channels;
+     header->samplerate = fileInfo.samplerate;
+     header->reserved = 0;
+     header->frames = data.size() / fileInfo.channels;
+     memcpy(header + 1, data.data(), data.size() * sizeof(float));
+
+     munmap(mapping, size);
+     return true;
+}
+
+static string runJob(const string &request)
+{
+     auto start = chrono::high_resolution_clock::now();
+
+     istringstream fields(request);
+     string input, chain, output, extra;
+     if (!(fields >> input >> chain >> output) || (fields >> extra))
+          return "ERR expected: <input> <filters> <output>";
+
+     vector<string> filters;
+     stringstream chainStream(chain);
+     string filter;
+     while (getline(chainStream, filter, ','))
+     {
+          if (filter != "bandpass" && filter != "notch" && filter != "fir" && filter != "iir")
+               return "ERR unknown filter " + filter;
+          filters.push_back(filter);
+     }
+
+     SF_INFO fileInfo;
+     memset(&fileInfo, 0, sizeof(fileInfo));
+     vector<float> data;
+
+     auto readStart = chrono::high_resolution_clock::now();
+     bool readOk = isSharedMemory(input) ? readSharedAudio(input.substr(SHARED_MEMORY_PREFIX.size()), data, fileInfo)
+                                         : readWavFile(input, data, fileInfo);
+     if (!readOk)
+          return "ERR cannot read " + input;
+
+     ostringstream reply;
+     reply << "OK frames=" << fileInfo.frames << " read_us=" << elapsedMicroseconds(readStart);
+
+     for (size_t i = 0; i < filters.size(); ++i)
+     {
+          auto filterStart = chrono::high_resolution_clock::now();
+          if (filters[i] == "bandpass")
+          {
+               applyBandPassFilter(data, fileInfo.samplerate, BANDPASS_BANDWIDTH);
+          }
+          else if (filters[i] == "notch")
+          {
+               applyNotchFilter(data, fileInfo.samplerate, NOTCH_FREQUENCY, NOTCH_ORDER);
+          }
+          else if (filters[i] == "fir")
+          {
+               vector<float> history;
+               applyFIRFilter(data, FIR_COEFFICIENTS, history);
+          }
+          else
+          {
+               vector<float> inputHistory, outputHistory;
+               applyIIRFilter(data, IIR_FEEDFORWARD, IIR_FEEDBACK, inputHistory, outputHistory);
+          }
+          reply << " " << filters[i] << "_us=" << elapsedMicroseconds(filterStart);
+     }
+
+     auto writeStart = chrono::high_resolution_clock::now();
+     bool writeOk = isSharedMemory(output) ? writeSharedAudio(output.substr(SHARED_MEMORY_PREFIX.size()), data, fileInfo)
+                                           : writeWavFile(output, data, fileInfo);
+     if (!writeOk)
+          return "ERR cannot write " + output;
+
+     reply << " write_us=" << elapsedMicroseconds(writeStart) << " total_us=" << elapsedMicroseconds(start);
+     return reply.str();
+}
+
+static bool sendAll(int fd, const string &message)
+{
+     size_t sent = 0;
+     while (sent < message.size())
+     {
+          ssize_t n = send(fd, message.data() + sent, message.size() - sent, 0);
+          if (n <= 0)
+               return false;
+          sent += n;
+     }
+     return true;
+}
+
+// An unterminated request longer than DAEMON_MAX_REQUEST is answered with an
+// error and the connection closed, so a client that never sends a newline cannot
+// grow the buffer without bound.
+static void serveClient(int client)
+{
+     char buffer[DAEMON_BUFFER_SIZE];
+     string pending;
+
+     while (true)
+     {
+          ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+          if (n <= 0)
+               return;
+          pending.append(buffer, n);
+
+          size_t newline;
+          while ((newline = pending.find('\n')) != string::npos)
+          {
+               string request = pending.substr(0, newline);
+               pending.erase(0, newline + 1);
+               if (!sendAll(client, runJob(request) + "\n"))
+                    return;
+          }
+          if (pending.size() > DAEMON_MAX_REQUEST)
+          {
+               sendAll(client, "ERR request too long\n");
+               return;
+          }
+     }
+}
+
+static void *connectionThread(void *arg)
+{
+     int client = static_cast<int>(reinterpret_cast<intptr_t>(arg));
+     serveClient(client);
+     close(client);
+     return nullptr;
+}
+
+// Accept errors such as running out of descriptors are logged and retried
+// after a short pause rather than in a tight loop.
+static int acceptClient(int listener)
+{
+     while (true)
+     {
+          int client = accept(listener, nullptr, nullptr);
+          if (client >= 0)
+               return client;
+          if (errno == EINTR || errno == ECONNABORTED)
+               continue;
+          cerr << "Error accepting daemon connection: " << strerror(errno) << endl;
+          usleep(DAEMON_ACCEPT_BACKOFF_US);
+     }
+}
+
+int runDaemon(const string &socketPath)
+{
+     struct sockaddr_un address;
+     memset(&address, 0, sizeof(address));
+     address.sun_family = AF_UNIX;
+     if (socketPath.size() >= sizeof(address.sun_path))
+     {
+          cerr << "Socket path too long: " << socketPath << endl;
+          return 1;
+     }
+     strcpy(address.sun_path, socketPath.c_str());
+
+     int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+     if (listener < 0)
+     {
+          cerr << "Error creating daemon socket: " << strerror(errno) << endl;
+          return 1;
+     }
+
+     unlink(socketPath.c_str());
+     if (bind(listener, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(listener, DAEMON_BACKLOG) < 0)
+     {
+          cerr << "Error listening on " << socketPath << ": " << strerror(errno) << endl;
+          close(listener);
+          return 1;
+     }
+
+     signal(SIGPIPE, SIG_IGN);
+     workerPool();
+     cout << "VoiceFilters daemon listening on " << socketPath << endl;
+
+     // Each connection gets its own detached thread, so an idle or slow
+     // client never holds up the others; their jobs share the worker pool.
+     pthread_attr_t attributes;
+     pthread_attr_init(&attributes);
+     pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+     while (true)
+     {
+          int client = acceptClient(listener);
+          pthread_t thread;
+          void *arg = reinterpret_cast<void *>(static_cast<intptr_t>(client));
+          if (pthread_create(&thread, &attributes, connectionThread, arg) != 0)
+          {
+               cerr << "Error creating daemon connection thread" << endl;
+               close(client);
+          }
+     }
+
+     pthread_attr_destroy(&attributes);
+     return 0;
+}
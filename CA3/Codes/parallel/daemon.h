@@ -0,0 +1,23 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <string>
+
+using namespace std;
+
+// Serves filter jobs over a Unix domain socket, keeping the worker pool
+// warm between jobs. Each request is one line:
+//
+//     <input> <filters> <output>
+//
+// where <input> and <output> are WAV paths or "shm:<name>" POSIX shared
+// memory objects (SharedAudioHeader followed by float samples) and
+// <filters> is a comma separated chain of bandpass, notch, fir and iir,
+// applied in order. The reply is one line, either
+//
+//     OK frames=<n> read_us=<t> <filter>_us=<t>... write_us=<t> total_us=<t>
+//
+// or "ERR <reason>".
+int runDaemon(const string &socketPath);
+
+#endif
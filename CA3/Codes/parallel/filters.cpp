@@ -0,0 +1,734 @@
+#include "filters.h"
+
+#include <iostream>
+#include <sndfile.h>
+#include <pthread.h>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <atomic>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include "types.h"
+#include "threadpool.h"
+#include "tracer.h"
+#include "voicefilters.h"
+#include "flac.h"
+
+using namespace std;
+
+static uint32_t littleEndian(const unsigned char *bytes, size_t count)
+{
+     uint32_t value = 0;
+     for (size_t i = 0; i < count; ++i)
+          value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+     return value;
+}
+
+// Walks the RIFF chunks for the format and the single data chunk. Only
+// little-endian integer PCM and 32-bit float are splittable: every frame has
+// the same size and a known position, which is what lets chunks be read
+// independently. Compressed, big-endian and other containers return false.
+static bool findWavLayout(int fd, const SF_INFO &fileInfo, WavLayout &layout)
+{
+     unsigned char riff[12];
+     if (pread(fd, riff, sizeof(riff), 0) != static_cast<ssize_t>(sizeof(riff)) ||
+         memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+          return false;
+
+     uint32_t audioFormat = 0, channels = 0, blockAlign = 0, bitsPerSample = 0;
+     off_t position = sizeof(riff);
+     unsigned char chunk[8];
+     while (pread(fd, chunk, sizeof(chunk), position) == static_cast<ssize_t>(sizeof(chunk)))
+     {
+          uint32_t size = littleEndian(chunk + 4, 4);
+          off_t body = position + sizeof(chunk);
+          if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+          {
+               unsigned char format[26];
+               ssize_t got = pread(fd, format, min<size_t>(size, sizeof(format)), body);
+               if (got < 16)
+                    return false;
+               audioFormat = littleEndian(format, 2);
+               channels = littleEndian(format + 2, 2);
+               blockAlign = littleEndian(format + 12, 2);
+               bitsPerSample = littleEndian(format + 14, 2);
+               // WAVE_FORMAT_EXTENSIBLE keeps the real format in its sub-format GUID.
+               if (audioFormat == 0xFFFE)
+                    audioFormat = got >= 26 ? littleEndian(format + 24, 2) : 0;
+          }
+          else if (memcmp(chunk, "data", 4) == 0)
+          {
+               size_t sampleBytes = bitsPerSample / 8;
+               bool integer = audioFormat == 1 && bitsPerSample % 8 == 0 && sampleBytes >= 1 && sampleBytes <= 4;
+               bool isFloat = audioFormat == 3 && bitsPerSample == 32;
+               if ((!integer && !isFloat) || channels != static_cast<uint32_t>(fileInfo.channels) ||
+                   blockAlign != channels * sampleBytes || size / blockAlign < static_cast<uint64_t>(fileInfo.frames))
+                    return false;
+               layout.fd = fd;
+               layout.dataOffset = body;
+               layout.sampleBytes = sampleBytes;
+               layout.isFloat = isFloat;
+               layout.channels = channels;
+               return true;
+          }
+          position = body + size + (size & 1);
+     }
+     return false;
+}
+
+// Converts with the same arithmetic libsndfile uses for normalised float
+// reads, so both paths produce identical samples.
+static void convertSamples(const unsigned char *bytes, float *out, size_t count, const WavLayout &layout)
+{
+     if (layout.isFloat)
+     {
+          for (size_t i = 0; i < count; ++i)
+          {
+               uint32_t bits = littleEndian(bytes + 4 * i, 4);
+               memcpy(&out[i], &bits, sizeof(float));
+          }
+          return;
+     }
+
+     switch (layout.sampleBytes)
+     {
+     case 1:
+          for (size_t i = 0; i < count; ++i)
+               out[i] = static_cast<float>(static_cast<int>(bytes[i]) - 128) * (1.0f / 0x80);
+          break;
+     case 2:
+          for (size_t i = 0; i < count; ++i)
+               out[i] = static_cast<float>(static_cast<int16_t>(littleEndian(bytes + 2 * i, 2))) * (1.0f / 0x8000);
+          break;
+     default:
+          // 24- and 32-bit samples are left-aligned into 32 bits first.
+          for (size_t i = 0; i < count; ++i)
+          {
+               uint32_t value = littleEndian(bytes + layout.sampleBytes * i, layout.sampleBytes) << (8 * (4 - layout.sampleBytes));
+               out[i] = static_cast<float>(static_cast<int32_t>(value)) * (1.0f / 0x80000000u);
+          }
+          break;
+     }
+}
+
+void *readChunk(void *args)
+{
+     ReadThreadArgs *threadArgs = static_cast<ReadThreadArgs *>(args);
+     const WavLayout &layout = *threadArgs->layout;
+     int64_t traceBegin = traceEnabled() ? traceNow() : 0;
+
+     size_t frameBytes = layout.sampleBytes * layout.channels;
+     size_t slabFrames = min(READ_SLAB_FRAMES, threadArgs->numFrames);
+     vector<unsigned char> slab(slabFrames * frameBytes);
+     float *out = threadArgs->data + (threadArgs->startFrame - threadArgs->baseFrame) * layout.channels;
+
+     threadArgs->ok = true;
+     for (size_t done = 0; done < threadArgs->numFrames; done += slabFrames)
+     {
+          size_t frames = min(slabFrames, threadArgs->numFrames - done);
+          size_t bytes = frames * frameBytes;
+          off_t offset = layout.dataOffset + static_cast<off_t>(threadArgs->startFrame + done) * frameBytes;
+          size_t got = 0;
+          while (got < bytes)
+          {
+               ssize_t n = pread(layout.fd, slab.data() + got, bytes - got, offset + got);
+               if (n <= 0)
+                    break;
+               got += n;
+          }
+          if (got != bytes)
+          {
+               cerr << "Error or EOF reached while reading in thread." << endl;
+               threadArgs->ok = false;
+               break;
+          }
+          convertSamples(slab.data(), out + done * layout.channels, frames * layout.channels, layout);
+     }
+
+     traceEvent("read chunk", "io", traceBegin, traceEnabled() ? traceNow() : 0,
+                threadArgs->startFrame, threadArgs->startFrame + threadArgs->numFrames);
+     return nullptr;
+}
+
+// Formats without fixed-size frames at known offsets go through one
+// libsndfile decoder that streams the whole range in order.
+static bool decodeSequentially(const string &inputFile, float *data, const SF_INFO &fileInfo, size_t startFrame)
+{
+     SF_INFO info = fileInfo;
+     SNDFILE *inFile = sf_open(inputFile.c_str(), SFM_READ, &info);
+     if (!inFile)
+     {
+          cerr << "Error opening input file: " << sf_strerror(NULL) << endl;
+          return false;
+     }
+
+     sf_count_t totalFrames = fileInfo.frames - startFrame;
+     bool ok = startFrame == 0 || sf_seek(inFile, startFrame, SEEK_SET) == static_cast<sf_count_t>(startFrame);
+     if (ok)
+          ok = sf_readf_float(inFile, data, totalFrames) == totalFrames;
+     if (!ok)
+          cerr << "Error or EOF reached while reading " << inputFile << endl;
+
+     sf_close(inFile);
+     return ok;
+}
+
+bool probeWavFile(const string &inputFile, SF_INFO &fileInfo)
+{
+     SNDFILE *inFile = sf_open(inputFile.c_str(), SFM_READ, &fileInfo);
+     if (!inFile)
+     {
+          cerr << "Error opening input file: " << sf_strerror(NULL) << endl;
+          return false;
+     }
+
+     sf_close(inFile);
+     return true;
+}
+
+bool readWavFile(const string &inputFile, vector<float> &data, SF_INFO &fileInfo, size_t startFrame)
+{
+     if (!probeWavFile(inputFile, fileInfo))
+          return false;
+
+     if (startFrame > static_cast<size_t>(fileInfo.frames))
+     {
+          cerr << "Input file " << inputFile << " has " << fileInfo.frames
+               << " frames, fewer than the " << startFrame << " already processed." << endl;
+          return false;
+     }
+
+     data.resize((fileInfo.frames - startFrame) * fileInfo.channels);
+     return readWavFrames(inputFile, data.data(), fileInfo, startFrame);
+}
+
+// The file is opened once. Splittable WAV data is then read by a pool of
+// threads issuing positioned reads on the shared descriptor; anything else
+// falls back to a single sequential decoder.
+bool readWavFrames(const string &inputFile, float *data, const SF_INFO &fileInfo, size_t startFrame)
+{
+     TraceScope trace("readWavFile", "io");
+     auto start = chrono::high_resolution_clock::now();
+
+     size_t totalFrames = fileInfo.frames - startFrame;
+     int fd = open(inputFile.c_str(), O_RDONLY);
+     if (fd < 0)
+     {
+          cerr << "Error opening input file: " << inputFile << endl;
+          return false;
+     }
+
+     WavLayout layout;
+     bool splittable = findWavLayout(fd, fileInfo, layout);
+     size_t numThreads = splittable ? max<size_t>(1, min(executionWidth(), totalFrames)) : 1;
+     bool ok = true;
+     if (splittable)
+     {
+          vector<ReadThreadArgs> threadArgs(numThreads);
+          vector<void *> args(numThreads);
+          size_t framesPerThread = totalFrames / numThreads;
+
+          for (size_t i = 0; i < numThreads; ++i)
+          {
+               threadArgs[i].layout = &layout;
+               threadArgs[i].data = data;
+               threadArgs[i].baseFrame = startFrame;
+               threadArgs[i].startFrame = startFrame + i * framesPerThread;
+               threadArgs[i].numFrames = (i == numThreads - 1) ? (totalFrames - i * framesPerThread) : framesPerThread;
+               threadArgs[i].ok = false;
+               args[i] = &threadArgs[i];
+          }
+
+          runWithPolicy(readChunk, args.data(), numThreads);
+          for (const ReadThreadArgs &threadArg : threadArgs)
+               ok = ok && threadArg.ok;
+     }
+     close(fd);
+     if (!splittable)
+          ok = decodeSequentially(inputFile, data, fileInfo, startFrame);
+     if (!ok)
+          return false;
+
+     auto end = chrono::high_resolution_clock::now();
+     cout << "Successfully read " << totalFrames << " frames from " << inputFile << endl;
+     cout << "    Reading time (" << (numThreads > 1 ? "multithreaded" : "sequential") << "): "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds\n"
+          << endl;
+     return true;
+}
+
+bool writeWavFile(const string &outputFile, const vector<float> &data, SF_INFO &fileInfo)
+{
+     return writeWavSamples(outputFile, data.data(), fileInfo);
+}
+
+static bool isFlacFile(const string &outputFile)
+{
+     const string extension = ".flac";
+     return outputFile.size() >= extension.size() &&
+            outputFile.compare(outputFile.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+string formatOutputFile(const string &outputFile, const string &format)
+{
+     if (format != "flac")
+          return outputFile;
+     return outputFile.substr(0, outputFile.rfind('.')) + ".flac";
+}
+
+bool writeWavSamples(const string &outputFile, const float *data, SF_INFO &fileInfo)
+{
+     if (isFlacFile(outputFile))
+          return writeFlacSamples(outputFile, data, fileInfo);
+
+     TraceScope trace("writeWavFile", "io");
+     auto start = chrono::high_resolution_clock::now();
+
+     sf_count_t originalFrames = fileInfo.frames;
+     SNDFILE *outFile = sf_open(outputFile.c_str(), SFM_WRITE, &fileInfo);
+     if (!outFile)
+     {
+          cerr << "Error opening output file: " << sf_strerror(NULL) << endl;
+          return false;
+     }
+     sf_count_t numFrames = sf_writef_float(outFile, data, originalFrames);
+     if (numFrames != originalFrames)
+     {
+          cerr << "Error writing frames to file." << endl;
+          sf_close(outFile);
+          return false;
+     }
+
+     sf_close(outFile);
+     auto end = chrono::high_resolution_clock::now();
+
+     cout << "    Successfully wrote " << numFrames << " frames to " << outputFile << endl;
+     cout << "    Writing time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds\n"
+          << endl;
+     return true;
+}
+
+bool appendWavFile(const string &outputFile, const vector<float> &data, size_t expectedFrames)
+{
+     TraceScope trace("appendWavFile", "io");
+     auto start = chrono::high_resolution_clock::now();
+
+     SF_INFO outInfo;
+     memset(&outInfo, 0, sizeof(outInfo));
+     SNDFILE *outFile = sf_open(outputFile.c_str(), SFM_RDWR, &outInfo);
+     if (!outFile)
+     {
+          cerr << "Error opening output file for append: " << sf_strerror(NULL) << endl;
+          return false;
+     }
+     if (outInfo.frames != static_cast<sf_count_t>(expectedFrames))
+     {
+          cerr << "Output file " << outputFile << " has " << outInfo.frames
+               << " frames but the checkpoint expects " << expectedFrames << endl;
+          sf_close(outFile);
+          return false;
+     }
+
+     sf_count_t framesToWrite = data.size() / outInfo.channels;
+     sf_seek(outFile, 0, SEEK_END);
+     sf_count_t numFrames = sf_writef_float(outFile, data.data(), framesToWrite);
+     if (numFrames != framesToWrite)
+     {
+          cerr << "Error appending frames to file." << endl;
+          sf_close(outFile);
+          return false;
+     }
+
+     sf_close(outFile);
+     auto end = chrono::high_resolution_clock::now();
+
+     cout << "    Successfully appended " << numFrames << " frames to " << outputFile << endl;
+     cout << "    Writing time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds\n"
+          << endl;
+     return true;
+}
+
+bool storeOutput(const string &outputFile, const vector<float> &data, SF_INFO &fileInfo, size_t startFrame)
+{
+     if (startFrame == 0)
+          return writeWavFile(outputFile, data, fileInfo);
+     return appendWavFile(outputFile, data, startFrame);
+}
+
+// Keeps exactly the most recent (length) samples of a filter history,
+// zero-padding at the front when the history is shorter.
+static void fitHistory(vector<float> &history, size_t length)
+{
+     if (history.size() < length)
+          history.insert(history.begin(), length - history.size(), 0.0f);
+     else
+          history.erase(history.begin(), history.end() - length);
+}
+
+// Runs library tasks under the current execution policy, recording a trace
+// event per chunk under the name of the stage that issued them.
+struct PoolExecutorContext
+{
+     const char *traceName;
+};
+
+struct PoolTask
+{
+     vf_task task;
+     void *arg;
+     size_t index;
+     const char *traceName;
+};
+
+// Fast IIR mode turns on flush-to-zero/denormals-are-zero for the main
+// thread when selected and for each pool worker before its next task.
+static atomic<bool> flushDenormals(false);
+static thread_local bool threadFlushesDenormals = false;
+
+static void syncDenormalMode()
+{
+     bool wanted = flushDenormals.load(memory_order_relaxed);
+     if (wanted != threadFlushesDenormals)
+     {
+          vf_set_flush_denormals(wanted);
+          threadFlushesDenormals = wanted;
+     }
+}
+
+void enableFastIIR()
+{
+     flushDenormals = true;
+     syncDenormalMode();
+}
+
+static void *runPoolTask(void *arg)
+{
+     PoolTask *poolTask = static_cast<PoolTask *>(arg);
+     syncDenormalMode();
+     TraceScope trace(poolTask->traceName, "chunk", poolTask->index, poolTask->index + 1);
+     poolTask->task(poolTask->arg, poolTask->index);
+     return nullptr;
+}
+
+static void poolParallelFor(void *context, size_t count, vf_task task, void *arg)
+{
+     PoolExecutorContext *executorContext = static_cast<PoolExecutorContext *>(context);
+     vector<PoolTask> tasks(count);
+     vector<void *> args(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          tasks[i] = {task, arg, i, executorContext->traceName};
+          args[i] = &tasks[i];
+     }
+     runWithPolicy(runPoolTask, args.data(), count);
+}
+
+static vf_executor poolExecutor(PoolExecutorContext &context)
+{
+     vf_executor executor = {poolParallelFor, &context, executionWidth()};
+     return executor;
+}
+
+static vf_buffer bufferOf(vector<float> &data)
+{
+     vf_buffer buffer = {data.data(), data.size(), 1};
+     return buffer;
+}
+
+static vf_view viewOf(const vector<float> &data)
+{
+     vf_view view = {data.data(), data.size(), 1};
+     return view;
+}
+
+// Bandpass and notch gains are closed-form in the absolute sample position,
+// so only the window [origin, origin + data.size()) is ever computed and an
+// incremental run pays for its new samples alone.
+static void applyGainCurve(vector<float> &data, int filterType, float sampleRate, float parameter, int order,
+                           size_t origin, const char *filterName, const char *traceName, const char *chunkTraceName)
+{
+     TraceScope trace(traceName, "stage");
+     PoolExecutorContext context = {chunkTraceName};
+     vf_executor executor = poolExecutor(context);
+     auto start = chrono::high_resolution_clock::now();
+
+     auto step1_start = chrono::high_resolution_clock::now();
+     vector<float> gains(data.size());
+     if (filterType == BANDPASS_FILTER)
+          vf_bandpass_gains(gains.data(), gains.size(), sampleRate, parameter, origin, &executor);
+     else
+          vf_notch_gains(gains.data(), gains.size(), sampleRate, parameter, order, origin, &executor);
+     auto step1_end = chrono::high_resolution_clock::now();
+
+     auto step2_start = chrono::high_resolution_clock::now();
+     vf_apply_gains(viewOf(data), bufferOf(data), gains.data(), &executor);
+     auto step2_end = chrono::high_resolution_clock::now();
+
+     auto end = chrono::high_resolution_clock::now();
+
+     cout << filterName << " Filtering time: " << endl;
+     cout << "    Step 1 (Gain Curve): "
+          << chrono::duration_cast<chrono::microseconds>(step1_end - step1_start).count()
+          << " microseconds" << endl;
+
+     cout << "    Step 2 (Processing): "
+          << chrono::duration_cast<chrono::microseconds>(step2_end - step2_start).count()
+          << " microseconds" << endl;
+
+     cout << "    Total Filtering Time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds" << endl;
+}
+
+void applyBandPassFilter(vector<float> &data, float sampleRate, float bandwidth, size_t origin)
+{
+     applyGainCurve(data, BANDPASS_FILTER, sampleRate, bandwidth, 0, origin, "Bandpass", "applyBandPassFilter", "bandpass chunk");
+}
+
+void applyNotchFilter(vector<float> &data, float sampleRate, float notchFreq, int order, size_t origin)
+{
+     applyGainCurve(data, NOTCH_FILTER, sampleRate, notchFreq, order, origin, "Notch", "applyNotchFilter", "notch chunk");
+}
+
+void applyFIRFilter(vector<float> &data, const vector<float> &coefficients, vector<float> &history)
+{
+     TraceScope trace("applyFIRFilter", "stage");
+     PoolExecutorContext context = {"fir chunk"};
+     vf_executor executor = poolExecutor(context);
+     auto start = chrono::high_resolution_clock::now();
+
+     auto step1_start = chrono::high_resolution_clock::now();
+     fitHistory(history, coefficients.size() - 1);
+     auto step1_end = chrono::high_resolution_clock::now();
+
+     auto step2_start = chrono::high_resolution_clock::now();
+     vf_fir(viewOf(data), bufferOf(data), coefficients.data(), coefficients.size(), history.data(), &executor);
+     auto step2_end = chrono::high_resolution_clock::now();
+
+     auto end = chrono::high_resolution_clock::now();
+
+     cout << "FIR Filtering time: " << endl;
+     cout << "    Step 1 (Initialization): "
+          << chrono::duration_cast<chrono::microseconds>(step1_end - step1_start).count()
+          << " microseconds" << endl;
+
+     cout << "    Step 2 (Convolution Loop): "
+          << chrono::duration_cast<chrono::microseconds>(step2_end - step2_start).count()
+          << " microseconds" << endl;
+
+     cout << "    Total Filtering Time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds" << endl;
+}
+
+void applyIIRFilter(vector<float> &data, const vector<float> &feedforward, const vector<float> &feedback,
+                    vector<float> &inputHistory, vector<float> &outputHistory)
+{
+     TraceScope trace("applyIIRFilter", "stage");
+     PoolExecutorContext context = {"iir feedforward chunk"};
+     vf_executor executor = poolExecutor(context);
+     auto start = chrono::high_resolution_clock::now();
+
+     auto step1_start = chrono::high_resolution_clock::now();
+     fitHistory(inputHistory, feedforward.size() - 1);
+     fitHistory(outputHistory, feedback.size() - 1);
+     auto step1_end = chrono::high_resolution_clock::now();
+
+     auto step2a_start = chrono::high_resolution_clock::now();
+     vf_fir(viewOf(data), bufferOf(data), feedforward.data(), feedforward.size(), inputHistory.data(), &executor);
+     auto step2a_end = chrono::high_resolution_clock::now();
+
+     auto step2b_start = chrono::high_resolution_clock::now();
+     {
+          TraceScope feedbackTrace("iir feedback", "stage");
+          if (flushDenormals)
+               vf_iir_feedback_double(bufferOf(data), feedback.data(), feedback.size(), outputHistory.data());
+          else
+               vf_iir_feedback(bufferOf(data), feedback.data(), feedback.size(), outputHistory.data());
+     }
+     auto step2b_end = chrono::high_resolution_clock::now();
+
+     auto end = chrono::high_resolution_clock::now();
+
+     cout << "IIR Filtering Time: " << endl;
+
+     cout << "    Step 1 (Initialization): "
+          << chrono::duration_cast<chrono::microseconds>(step1_end - step1_start).count()
+          << " microseconds" << endl;
+
+     cout << "    Step 2a (Feedforward computation): "
+          << chrono::duration_cast<chrono::microseconds>(step2a_end - step2a_start).count()
+          << " microseconds" << endl;
+
+     cout << "    Step 2b (Feedback computation" << (flushDenormals ? ", fast" : "") << "): "
+          << chrono::duration_cast<chrono::microseconds>(step2b_end - step2b_start).count()
+          << " microseconds" << endl;
+
+     cout << "    Total Filtering Time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds" << endl;
+}
+
+// Resampling uses a (RESAMPLER_TAPS_PER_PHASE * factor + 1)-tap linear-phase
+// prototype, whose group delay is exactly RESAMPLER_TAPS_PER_PHASE / 2
+// low-rate samples; both directions pad by that much and drop it again so
+// the resampled signal stays aligned with the input.
+static vector<float> resamplingTaps(size_t factor)
+{
+     vector<float> taps(RESAMPLER_TAPS_PER_PHASE * factor + 1);
+     vf_design_lowpass(taps.data(), taps.size(), RESAMPLER_PASSBAND * 0.5f / factor);
+     return taps;
+}
+
+void decimateAudio(vector<float> &data, SF_INFO &fileInfo, size_t factor)
+{
+     TraceScope trace("decimateAudio", "stage");
+     PoolExecutorContext context = {"decimate chunk"};
+     vf_executor executor = poolExecutor(context);
+     auto start = chrono::high_resolution_clock::now();
+
+     vector<float> taps = resamplingTaps(factor);
+     size_t delay = RESAMPLER_TAPS_PER_PHASE / 2;
+     size_t channels = fileInfo.channels;
+     size_t frames = fileInfo.frames;
+     size_t outFrames = vf_decimated_length(frames, factor);
+
+     vector<float> padded(frames + delay * factor, 0.0f);
+     vector<float> decimated(vf_decimated_length(padded.size(), factor));
+     vector<float> result(outFrames * channels);
+
+     for (size_t c = 0; c < channels; ++c)
+     {
+          for (size_t f = 0; f < frames; ++f)
+               padded[f] = data[f * channels + c];
+          vf_decimate(viewOf(padded), bufferOf(decimated), factor, taps.data(), taps.size(), nullptr, &executor);
+          for (size_t m = 0; m < outFrames; ++m)
+               result[m * channels + c] = decimated[m + delay];
+     }
+
+     data.swap(result);
+     fileInfo.frames = outFrames;
+     fileInfo.samplerate /= factor;
+
+     auto end = chrono::high_resolution_clock::now();
+     cout << "Decimated by " << factor << " to " << fileInfo.samplerate << " Hz: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds\n"
+          << endl;
+}
+
+void interpolateAudio(vector<float> &data, SF_INFO &fileInfo, size_t factor, const SF_INFO &targetInfo)
+{
+     TraceScope trace("interpolateAudio", "stage");
+     PoolExecutorContext context = {"interpolate chunk"};
+     vf_executor executor = poolExecutor(context);
+     auto start = chrono::high_resolution_clock::now();
+
+     vector<float> taps = resamplingTaps(factor);
+     size_t delay = RESAMPLER_TAPS_PER_PHASE / 2;
+     size_t channels = fileInfo.channels;
+     size_t frames = data.size() / channels;
+     size_t outFrames = min<size_t>(targetInfo.frames, frames * factor);
+
+     vector<float> padded(frames + delay, 0.0f);
+     vector<float> interpolated(padded.size() * factor);
+     vector<float> result(targetInfo.frames * channels, 0.0f);
+
+     for (size_t c = 0; c < channels; ++c)
+     {
+          for (size_t f = 0; f < frames; ++f)
+               padded[f] = data[f * channels + c];
+          vf_interpolate(viewOf(padded), bufferOf(interpolated), factor, taps.data(), taps.size(), nullptr, &executor);
+          for (size_t f = 0; f < outFrames; ++f)
+               result[f * channels + c] = interpolated[f + delay * factor];
+     }
+
+     data.swap(result);
+     fileInfo.frames = targetInfo.frames;
+     fileInfo.samplerate = targetInfo.samplerate;
+
+     auto end = chrono::high_resolution_clock::now();
+     cout << "    Interpolated by " << factor << " to " << fileInfo.samplerate << " Hz: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds" << endl;
+}
+
+bool parseEqualizer(const string &spec, vector<float> &frequencies, vector<float> &gainsDb)
+{
+     frequencies.clear();
+     gainsDb.clear();
+     if (spec == "flat")
+          return true;
+
+     stringstream points(spec);
+     string point;
+     while (getline(points, point, ','))
+     {
+          float frequency, gain;
+          char separator;
+          stringstream fields(point);
+          if (!(fields >> frequency >> separator >> gain) || separator != ':' || !fields.eof() ||
+              (!frequencies.empty() && frequency <= frequencies.back()))
+          {
+               cerr << "Invalid equalizer point \"" << point << "\", expected increasing <hz>:<db> pairs" << endl;
+               return false;
+          }
+          frequencies.push_back(frequency);
+          gainsDb.push_back(gain);
+     }
+     return !frequencies.empty();
+}
+
+void applySpectralFilter(vector<float> &data, int channels, float sampleRate, float bandwidth, float notchFreq,
+                         int order, const vector<float> &eqFrequencies, const vector<float> &eqGainsDb)
+{
+     TraceScope trace("applySpectralFilter", "stage");
+     PoolExecutorContext context = {"stft chunk"};
+     vf_executor executor = poolExecutor(context);
+     auto start = chrono::high_resolution_clock::now();
+
+     auto step1_start = chrono::high_resolution_clock::now();
+     vector<float> mask(SPECTRAL_FRAME_SIZE / 2 + 1, 1.0f);
+     vf_bandpass_mask(mask.data(), SPECTRAL_FRAME_SIZE, sampleRate, bandwidth);
+     vf_notch_mask(mask.data(), SPECTRAL_FRAME_SIZE, sampleRate, notchFreq, order);
+     if (!eqFrequencies.empty())
+          vf_eq_mask(mask.data(), SPECTRAL_FRAME_SIZE, sampleRate, eqFrequencies.data(), eqGainsDb.data(),
+                     eqFrequencies.size());
+     auto step1_end = chrono::high_resolution_clock::now();
+
+     auto step2_start = chrono::high_resolution_clock::now();
+     vector<float> filtered(data.size());
+     size_t frames = data.size() / channels;
+     for (int c = 0; c < channels; ++c)
+     {
+          vf_view in = {data.data() + c, frames, channels};
+          vf_buffer out = {filtered.data() + c, frames, channels};
+          vf_stft_filter(in, out, SPECTRAL_FRAME_SIZE, mask.data(), &executor);
+     }
+     data.swap(filtered);
+     auto step2_end = chrono::high_resolution_clock::now();
+
+     auto end = chrono::high_resolution_clock::now();
+
+     cout << "Spectral Filtering time: " << endl;
+     cout << "    Step 1 (Mask): "
+          << chrono::duration_cast<chrono::microseconds>(step1_end - step1_start).count()
+          << " microseconds" << endl;
+
+     cout << "    Step 2 (STFT Processing): "
+          << chrono::duration_cast<chrono::microseconds>(step2_end - step2_start).count()
+          << " microseconds" << endl;
+
+     cout << "    Total Filtering Time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds" << endl;
+}
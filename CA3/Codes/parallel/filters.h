@@ -0,0 +1,38 @@
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include <sndfile.h>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+bool probeWavFile(const string &inputFile, SF_INFO &fileInfo);
+bool readWavFile(const string &inputFile, vector<float> &data, SF_INFO &fileInfo, size_t startFrame = 0);
+bool readWavFrames(const string &inputFile, float *data, const SF_INFO &fileInfo, size_t startFrame);
+// Output paths ending in .flac are encoded as FLAC instead of WAV.
+string formatOutputFile(const string &outputFile, const string &format);
+bool writeWavFile(const string &outputFile, const vector<float> &data, SF_INFO &fileInfo);
+bool writeWavSamples(const string &outputFile, const float *data, SF_INFO &fileInfo);
+bool appendWavFile(const string &outputFile, const vector<float> &data, size_t expectedFrames);
+bool storeOutput(const string &outputFile, const vector<float> &data, SF_INFO &fileInfo, size_t startFrame);
+
+void applyBandPassFilter(vector<float> &data, float sampleRate, float bandwidth, size_t origin = 0);
+void applyNotchFilter(vector<float> &data, float sampleRate, float notchFreq, int order, size_t origin = 0);
+void applyFIRFilter(vector<float> &data, const vector<float> &coefficients, vector<float> &history);
+// Selects the fast IIR mode: FTZ/DAZ on every thread that runs filters and a
+// double-precision feedback recursion. Outputs are no longer bit-identical.
+void enableFastIIR();
+void applyIIRFilter(vector<float> &data, const vector<float> &feedforward, const vector<float> &feedback,
+                    vector<float> &inputHistory, vector<float> &outputHistory);
+
+// Bandpass, notch and an optional equalizer curve applied together as one
+// per-bin mask in a single STFT pass, per channel.
+bool parseEqualizer(const string &spec, vector<float> &frequencies, vector<float> &gainsDb);
+void applySpectralFilter(vector<float> &data, int channels, float sampleRate, float bandwidth, float notchFreq,
+                         int order, const vector<float> &eqFrequencies, const vector<float> &eqGainsDb);
+
+void decimateAudio(vector<float> &data, SF_INFO &fileInfo, size_t factor);
+void interpolateAudio(vector<float> &data, SF_INFO &fileInfo, size_t factor, const SF_INFO &targetInfo);
+
+#endif
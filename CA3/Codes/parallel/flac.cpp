@@ -0,0 +1,455 @@
+#include "flac.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "types.h"
+#include "threadpool.h"
+#include "tracer.h"
+
+using namespace std;
+
+// Channel assignments from the FLAC frame header; anything below
+// FLAC_LEFT_SIDE is (channels - 1) independently coded channels.
+enum
+{
+     FLAC_LEFT_SIDE = 8,
+     FLAC_RIGHT_SIDE = 9,
+     FLAC_MID_SIDE = 10
+};
+
+static const int MAX_FIXED_ORDER = 4;
+static const int MAX_PARTITION_ORDER = 8;
+static const int MAX_RICE_PARAMETER = 14;
+
+class BitWriter
+{
+public:
+     void write(uint64_t value, int bits)
+     {
+          accumulator = (accumulator << bits) | (value & ((uint64_t(1) << bits) - 1));
+          pending += bits;
+          while (pending >= 8)
+          {
+               pending -= 8;
+               bytes.push_back(static_cast<uint8_t>(accumulator >> pending));
+          }
+     }
+
+     void writeUnary(uint64_t zeros)
+     {
+          for (; zeros >= 32; zeros -= 32)
+               write(0, 32);
+          write(1, zeros + 1);
+     }
+
+     void align()
+     {
+          if (pending > 0)
+               write(0, 8 - pending);
+     }
+
+     vector<uint8_t> bytes;
+
+private:
+     uint64_t accumulator = 0;
+     int pending = 0;
+};
+
+static uint8_t crc8(const uint8_t *data, size_t length)
+{
+     uint8_t crc = 0;
+     for (size_t i = 0; i < length; ++i)
+     {
+          crc ^= data[i];
+          for (int b = 0; b < 8; ++b)
+               crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+     }
+     return crc;
+}
+
+static uint16_t crc16(const uint8_t *data, size_t length)
+{
+     uint16_t crc = 0;
+     for (size_t i = 0; i < length; ++i)
+     {
+          crc ^= static_cast<uint16_t>(data[i]) << 8;
+          for (int b = 0; b < 8; ++b)
+               crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x8005) : static_cast<uint16_t>(crc << 1);
+     }
+     return crc;
+}
+
+static uint64_t zigzag(int64_t residual)
+{
+     return residual >= 0 ? uint64_t(residual) << 1 : (uint64_t(-residual) << 1) - 1;
+}
+
+// Residual of the order-th fixed polynomial predictor at position i.
+static int64_t fixedResidual(const int64_t *x, size_t i, int order)
+{
+     switch (order)
+     {
+     case 0:
+          return x[i];
+     case 1:
+          return x[i] - x[i - 1];
+     case 2:
+          return x[i] - 2 * x[i - 1] + x[i - 2];
+     case 3:
+          return x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+     default:
+          return x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+     }
+}
+
+// How one channel of one block will be coded: verbatim (order < 0),
+// constant, or a fixed predictor with partitioned Rice residuals.
+struct SubframePlan
+{
+     bool constant;
+     int order;
+     int partitionOrder;
+     vector<int> parameters;
+     uint64_t bits;
+};
+
+static int riceParameter(uint64_t sum, size_t count, uint64_t &bits)
+{
+     int estimate = 0;
+     while (estimate < MAX_RICE_PARAMETER && (uint64_t(count) << (estimate + 1)) < sum)
+          ++estimate;
+
+     int best = estimate;
+     bits = UINT64_MAX;
+     for (int k = max(0, estimate - 1); k <= min(MAX_RICE_PARAMETER, estimate + 1); ++k)
+     {
+          // Approximates the unary quotients by sum >> k rather than
+          // revisiting every residual for each candidate.
+          uint64_t cost = (sum >> k) + count * (k + 1);
+          if (cost < bits)
+          {
+               bits = cost;
+               best = k;
+          }
+     }
+     return best;
+}
+
+static SubframePlan planSubframe(const vector<int64_t> &x, int bps)
+{
+     size_t n = x.size();
+     SubframePlan plan = {false, -1, 0, {}, 8 + uint64_t(n) * bps};
+
+     if (all_of(x.begin(), x.end(), [&](int64_t v) { return v == x[0]; }))
+     {
+          plan.constant = true;
+          plan.bits = 8 + bps;
+          return plan;
+     }
+
+     vector<uint64_t> residuals(n);
+     for (int order = 0; order <= MAX_FIXED_ORDER && size_t(order) < n; ++order)
+     {
+          for (size_t i = order; i < n; ++i)
+               residuals[i] = zigzag(fixedResidual(x.data(), i, order));
+
+          for (int p = 0; p <= MAX_PARTITION_ORDER; ++p)
+          {
+               size_t partitions = size_t(1) << p;
+               if (n % partitions != 0 || n / partitions <= size_t(order))
+                    break;
+
+               uint64_t bits = 8 + uint64_t(order) * bps + 6;
+               vector<int> parameters(partitions);
+               for (size_t part = 0; part < partitions; ++part)
+               {
+                    size_t first = max(part * (n / partitions), size_t(order));
+                    size_t last = (part + 1) * (n / partitions);
+                    uint64_t sum = 0, partBits = 0;
+                    for (size_t i = first; i < last; ++i)
+                         sum += residuals[i];
+                    parameters[part] = riceParameter(sum, last - first, partBits);
+                    bits += 4 + partBits;
+               }
+
+               if (bits < plan.bits)
+                    plan = {false, order, p, parameters, bits};
+          }
+     }
+     return plan;
+}
+
+static void writeSubframe(BitWriter &out, const vector<int64_t> &x, int bps, const SubframePlan &plan)
+{
+     size_t n = x.size();
+     out.write(0, 1);
+     if (plan.constant)
+     {
+          out.write(0x00, 6);
+          out.write(0, 1);
+          out.write(uint64_t(x[0]), bps);
+          return;
+     }
+     if (plan.order < 0)
+     {
+          out.write(0x01, 6);
+          out.write(0, 1);
+          for (size_t i = 0; i < n; ++i)
+               out.write(uint64_t(x[i]), bps);
+          return;
+     }
+
+     out.write(0x08 | plan.order, 6);
+     out.write(0, 1);
+     for (int i = 0; i < plan.order; ++i)
+          out.write(uint64_t(x[i]), bps);
+
+     size_t partitions = size_t(1) << plan.partitionOrder;
+     out.write(0, 2);
+     out.write(plan.partitionOrder, 4);
+     for (size_t part = 0; part < partitions; ++part)
+     {
+          int k = plan.parameters[part];
+          out.write(k, 4);
+          size_t first = max(part * (n / partitions), size_t(plan.order));
+          size_t last = (part + 1) * (n / partitions);
+          for (size_t i = first; i < last; ++i)
+          {
+               uint64_t u = zigzag(fixedResidual(x.data(), i, plan.order));
+               out.writeUnary(u >> k);
+               out.write(u, k);
+          }
+     }
+}
+
+static void writeFrameNumber(BitWriter &out, uint64_t value)
+{
+     if (value < 0x80)
+     {
+          out.write(value, 8);
+          return;
+     }
+
+     int continuation = 1;
+     while (continuation < 6 && value >= (uint64_t(1) << (6 * continuation + 6 - continuation)))
+          ++continuation;
+     out.write((0xFF00 >> (continuation + 1)) | (value >> (6 * continuation)), 8);
+     for (int i = continuation - 1; i >= 0; --i)
+          out.write(0x80 | ((value >> (6 * i)) & 0x3F), 8);
+}
+
+struct FlacBlockTask
+{
+     const float *data;
+     int channels;
+     int bps;
+     size_t blockNumber;
+     size_t firstFrame;
+     size_t numFrames;
+     vector<uint8_t> encoded;
+};
+
+static int64_t quantize(float sample, int bps)
+{
+     double scale = double((int64_t(1) << (bps - 1)) - 1);
+     double value = floor(double(sample) * scale + 0.5);
+     return int64_t(max(-scale - 1, min(scale, value)));
+}
+
+static void *encodeFlacBlock(void *arg)
+{
+     FlacBlockTask *task = static_cast<FlacBlockTask *>(arg);
+     TraceScope trace("flac block", "io");
+     size_t n = task->numFrames;
+     int channels = task->channels;
+
+     vector<vector<int64_t>> samples(channels, vector<int64_t>(n));
+     for (size_t i = 0; i < n; ++i)
+          for (int c = 0; c < channels; ++c)
+               samples[c][i] = quantize(task->data[(task->firstFrame + i) * channels + c], task->bps);
+
+     // Stereo blocks try the three side-channel decorrelations as well and
+     // keep whichever pair of subframes is smallest.
+     int assignment = channels - 1;
+     vector<vector<int64_t>> coded = samples;
+     vector<int> codedBps(channels, task->bps);
+     vector<SubframePlan> plans;
+     for (int c = 0; c < channels; ++c)
+          plans.push_back(planSubframe(samples[c], task->bps));
+
+     if (channels == 2)
+     {
+          vector<int64_t> mid(n), side(n);
+          for (size_t i = 0; i < n; ++i)
+          {
+               mid[i] = (samples[0][i] + samples[1][i]) >> 1;
+               side[i] = samples[0][i] - samples[1][i];
+          }
+          SubframePlan midPlan = planSubframe(mid, task->bps);
+          SubframePlan sidePlan = planSubframe(side, task->bps + 1);
+
+          uint64_t best = plans[0].bits + plans[1].bits;
+          vector<int64_t> left = samples[0], right = samples[1];
+          SubframePlan leftPlan = plans[0], rightPlan = plans[1];
+          if (leftPlan.bits + sidePlan.bits < best)
+          {
+               best = leftPlan.bits + sidePlan.bits;
+               assignment = FLAC_LEFT_SIDE;
+               coded = {left, side};
+               codedBps = {task->bps, task->bps + 1};
+               plans = {leftPlan, sidePlan};
+          }
+          if (sidePlan.bits + rightPlan.bits < best)
+          {
+               best = sidePlan.bits + rightPlan.bits;
+               assignment = FLAC_RIGHT_SIDE;
+               coded = {side, right};
+               codedBps = {task->bps + 1, task->bps};
+               plans = {sidePlan, rightPlan};
+          }
+          if (midPlan.bits + sidePlan.bits < best)
+          {
+               assignment = FLAC_MID_SIDE;
+               coded = {mid, side};
+               codedBps = {task->bps, task->bps + 1};
+               plans = {midPlan, sidePlan};
+          }
+     }
+
+     BitWriter out;
+     bool fullBlock = n == FLAC_BLOCK_SIZE;
+     out.write(0x3FFE, 14);
+     out.write(0, 1);
+     out.write(0, 1);
+     out.write(fullBlock ? FLAC_BLOCK_SIZE_CODE : 7, 4);
+     out.write(0, 4);
+     out.write(assignment, 4);
+     out.write(task->bps == 24 ? 6 : 4, 3);
+     out.write(0, 1);
+     writeFrameNumber(out, task->blockNumber);
+     if (!fullBlock)
+          out.write(n - 1, 16);
+     out.write(crc8(out.bytes.data(), out.bytes.size()), 8);
+
+     for (int c = 0; c < channels; ++c)
+          writeSubframe(out, coded[c], codedBps[c], plans[c]);
+
+     out.align();
+     out.write(crc16(out.bytes.data(), out.bytes.size()), 16);
+     task->encoded.swap(out.bytes);
+     return nullptr;
+}
+
+static vector<uint8_t> streamHeader(const SF_INFO &fileInfo, int bps, size_t minFrameBytes, size_t maxFrameBytes)
+{
+     BitWriter out;
+     for (char c : string("fLaC"))
+          out.write(c, 8);
+
+     out.write(1, 1);
+     out.write(0, 7);
+     out.write(34, 24);
+     out.write(FLAC_BLOCK_SIZE, 16);
+     out.write(FLAC_BLOCK_SIZE, 16);
+     out.write(minFrameBytes, 24);
+     out.write(maxFrameBytes, 24);
+     out.write(fileInfo.samplerate, 20);
+     out.write(fileInfo.channels - 1, 3);
+     out.write(bps - 1, 5);
+     out.write(fileInfo.frames, 36);
+     for (int i = 0; i < 4; ++i)
+          out.write(0, 32);
+     return out.bytes;
+}
+
+int flacBitsPerSample(const SF_INFO &fileInfo)
+{
+     switch (fileInfo.format & SF_FORMAT_SUBMASK)
+     {
+     case SF_FORMAT_FLOAT:
+     case SF_FORMAT_DOUBLE:
+     case SF_FORMAT_PCM_32:
+          return 0;
+     case SF_FORMAT_PCM_24:
+          return 24;
+     default:
+          return 16;
+     }
+}
+
+bool checkFlacInput(const string &inputFile, const SF_INFO &fileInfo)
+{
+     if (flacBitsPerSample(fileInfo) > 0)
+          return true;
+     cerr << "Cannot write " << inputFile << " as lossless FLAC: float and 32-bit samples need --format wav" << endl;
+     return false;
+}
+
+bool writeFlacSamples(const string &outputFile, const float *data, const SF_INFO &fileInfo)
+{
+     TraceScope trace("writeFlacFile", "io");
+     auto start = chrono::high_resolution_clock::now();
+
+     if (fileInfo.channels < 1 || fileInfo.channels > 8 || fileInfo.samplerate <= 0 || fileInfo.samplerate >= (1 << 20))
+     {
+          cerr << "Cannot encode " << fileInfo.channels << " channels at " << fileInfo.samplerate << " Hz as FLAC" << endl;
+          return false;
+     }
+
+     int bps = flacBitsPerSample(fileInfo);
+     if (bps == 0)
+     {
+          cerr << "Cannot encode float or 32-bit samples as lossless FLAC" << endl;
+          return false;
+     }
+     size_t frames = fileInfo.frames;
+     size_t numBlocks = (frames + FLAC_BLOCK_SIZE - 1) / FLAC_BLOCK_SIZE;
+
+     vector<FlacBlockTask> tasks(numBlocks);
+     vector<void *> args(numBlocks);
+     for (size_t b = 0; b < numBlocks; ++b)
+     {
+          size_t first = b * FLAC_BLOCK_SIZE;
+          tasks[b] = {data, fileInfo.channels, bps, b, first, min<size_t>(FLAC_BLOCK_SIZE, frames - first), {}};
+          args[b] = &tasks[b];
+     }
+     runWithPolicy(encodeFlacBlock, args.data(), numBlocks);
+
+     size_t minFrameBytes = 0, maxFrameBytes = 0, totalBytes = 0;
+     for (const FlacBlockTask &task : tasks)
+     {
+          minFrameBytes = minFrameBytes == 0 ? task.encoded.size() : min(minFrameBytes, task.encoded.size());
+          maxFrameBytes = max(maxFrameBytes, task.encoded.size());
+     }
+
+     ofstream out(outputFile, ios::binary | ios::trunc);
+     vector<uint8_t> header = streamHeader(fileInfo, bps, minFrameBytes, maxFrameBytes);
+     out.write(reinterpret_cast<const char *>(header.data()), header.size());
+     totalBytes += header.size();
+     for (const FlacBlockTask &task : tasks)
+     {
+          out.write(reinterpret_cast<const char *>(task.encoded.data()), task.encoded.size());
+          totalBytes += task.encoded.size();
+     }
+     out.close();
+     if (!out)
+     {
+          cerr << "Error writing FLAC file " << outputFile << endl;
+          return false;
+     }
+
+     auto end = chrono::high_resolution_clock::now();
+
+     cout << "    Successfully wrote " << frames << " frames to " << outputFile
+          << " (" << totalBytes << " bytes, " << numBlocks << " blocks)" << endl;
+     cout << "    Writing time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count()
+          << " microseconds\n"
+          << endl;
+     return true;
+}
@@ -0,0 +1,22 @@
+#ifndef FLAC_H
+#define FLAC_H
+
+#include <sndfile.h>
+#include <string>
+
+using namespace std;
+
+// Encodes interleaved float samples as a FLAC stream. Blocks of
+// FLAC_BLOCK_SIZE frames are independent FLAC frames, so they are encoded
+// in parallel on the worker pool and written out in order.
+bool writeFlacSamples(const string &outputFile, const float *data, const SF_INFO &fileInfo);
+
+// FLAC stores integer samples of at most 24 bits here, so the output is
+// lossless only for integer input of that width: 24-bit PCM is encoded at
+// 24 bits and narrower formats at 16. Float, double and 32-bit PCM input
+// would lose precision and are refused; flacBitsPerSample returns 0 for
+// them and checkFlacInput reports it for inputFile.
+int flacBitsPerSample(const SF_INFO &fileInfo);
+bool checkFlacInput(const string &inputFile, const SF_INFO &fileInfo);
+
+#endif
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include "types.h"
+#include "voicefilters.h"
+
+using namespace std;
+
+// Times the serial IIR feedback recursion (Step 2b) on quiet inputs, in the
+// exact float mode and in the fast mode (FTZ/DAZ, double state). Tails that
+// decay toward silence keep float recursion on subnormal values forever.
+static const size_t BENCH_SAMPLES = 20 * 1000 * 1000;
+static const float BENCH_SAMPLE_RATE = 44100.0f;
+
+static vector<float> silence()
+{
+     return vector<float>(BENCH_SAMPLES, 0.0f);
+}
+
+// One second of a 440 Hz tone fading out, then digital silence.
+static vector<float> fadeOut()
+{
+     vector<float> data(BENCH_SAMPLES, 0.0f);
+     for (size_t i = 0; i < BENCH_SAMPLE_RATE; ++i)
+     {
+          float fade = 1.0f - i / BENCH_SAMPLE_RATE;
+          data[i] = 0.5f * fade * sin(2.0f * 3.14159265f * 440.0f * i / BENCH_SAMPLE_RATE);
+     }
+     return data;
+}
+
+// A noise floor far below anything audible, itself subnormal.
+static vector<float> nearSilence()
+{
+     vector<float> data(BENCH_SAMPLES);
+     unsigned int seed = 1;
+     for (size_t i = 0; i < BENCH_SAMPLES; ++i)
+     {
+          seed = seed * 1103515245u + 12345u;
+          data[i] = ((seed >> 16) & 0xFF) * 1e-43f;
+     }
+     return data;
+}
+
+static long long timeFeedback(vector<float> data, bool fast)
+{
+     vector<float> history(IIR_FEEDBACK.size() - 1, 0.0f);
+     vf_buffer buffer = {data.data(), data.size(), 1};
+     vf_set_flush_denormals(fast);
+
+     auto start = chrono::high_resolution_clock::now();
+     if (fast)
+          vf_iir_feedback_double(buffer, IIR_FEEDBACK.data(), IIR_FEEDBACK.size(), history.data());
+     else
+          vf_iir_feedback(buffer, IIR_FEEDBACK.data(), IIR_FEEDBACK.size(), history.data());
+     auto end = chrono::high_resolution_clock::now();
+
+     vf_set_flush_denormals(0);
+     return chrono::duration_cast<chrono::microseconds>(end - start).count();
+}
+
+int main()
+{
+     struct
+     {
+          const char *name;
+          vector<float> (*make)();
+     } cases[] = {{"silence", silence}, {"fade-out", fadeOut}, {"near-silence", nearSilence}};
+
+     cout << "IIR feedback on " << BENCH_SAMPLES << " samples:" << endl;
+     for (auto &benchCase : cases)
+     {
+          vector<float> data = benchCase.make();
+          long long exact = timeFeedback(data, false);
+          long long fast = timeFeedback(data, true);
+          cout << "    " << benchCase.name << ": exact " << exact << " microseconds, fast " << fast
+               << " microseconds (" << (fast > 0 ? double(exact) / fast : 0.0) << "x)" << endl;
+     }
+     return 0;
+}
@@ -6,488 +6,193 @@
 #include <cmath>
 #include <chrono>
 #include "types.h"
+#include "filters.h"
+#include "threadpool.h"
+#include "checkpoint.h"
+#include "tracer.h"
+#include "daemon.h"
+#include "shard.h"
+#include "memory.h"
+#include "verify.h"
+#include "flac.h"
 
 using namespace std;
 
-#include <sndfile.h>
-#include <pthread.h>
-#include <vector>
-#include <string>
-#include <iostream>
-#include <chrono>
-
-using namespace std;
-
-void *readChunk(void *args)
-{
-     ReadThreadArgs *threadArgs = static_cast<ReadThreadArgs *>(args);
-
-     SNDFILE *inFile = sf_open(threadArgs->inputFile.c_str(), SFM_READ, &threadArgs->fileInfo);
-     if (!inFile)
-     {
-          cerr << "Error opening input file in thread: " << sf_strerror(NULL) << endl;
-          pthread_exit(nullptr);
-     }
-
-     sf_seek(inFile, threadArgs->startFrame, SEEK_SET);
-
-     sf_count_t framesRead = sf_readf_float(inFile, threadArgs->data->data() + threadArgs->startFrame * threadArgs->channels, threadArgs->numFrames);
-
-     if (framesRead != threadArgs->numFrames)
-     {
-          cerr << "Error or EOF reached while reading in thread." << endl;
-     }
-
-     sf_close(inFile);
-     pthread_exit(nullptr);
-}
-
-void readWavFile(const string &inputFile, vector<float> &data, SF_INFO &fileInfo)
-{
-     size_t numThreads = 4;
-     auto start = chrono::high_resolution_clock::now();
-
-     SNDFILE *inFile = sf_open(inputFile.c_str(), SFM_READ, &fileInfo);
-     if (!inFile)
-     {
-          cerr << "Error opening input file: " << sf_strerror(NULL) << endl;
-          exit(1);
-     }
-
-     size_t totalFrames = fileInfo.frames;
-     size_t channels = fileInfo.channels;
-
-     data.resize(totalFrames * channels);
-
-     sf_close(inFile);
-
-     vector<pthread_t> threads(numThreads);
-     vector<ReadThreadArgs> threadArgs(numThreads);
-
-     size_t framesPerThread = totalFrames / numThreads;
-
-     for (size_t i = 0; i < numThreads; ++i)
-     {
-          threadArgs[i].inputFile = inputFile;
-          threadArgs[i].data = &data;
-          threadArgs[i].fileInfo = fileInfo;
-          threadArgs[i].startFrame = i * framesPerThread;
-          threadArgs[i].numFrames = (i == numThreads - 1) ? (totalFrames - i * framesPerThread) : framesPerThread;
-          threadArgs[i].channels = channels;
-
-          pthread_create(&threads[i], nullptr, readChunk, &threadArgs[i]);
-     }
-
-     for (size_t i = 0; i < numThreads; ++i)
-     {
-          pthread_join(threads[i], nullptr);
-     }
-
-     auto end = chrono::high_resolution_clock::now();
-     cout << "Successfully read " << totalFrames << " frames from " << inputFile << endl;
-     cout << "    Reading time (multithreaded): "
-          << chrono::duration_cast<chrono::microseconds>(end - start).count()
-          << " microseconds\n"
-          << endl;
-}
-
-void writeWavFile(const string &outputFile, const vector<float> &data, SF_INFO &fileInfo)
-{
-     auto start = chrono::high_resolution_clock::now();
-
-     sf_count_t originalFrames = fileInfo.frames;
-     SNDFILE *outFile = sf_open(outputFile.c_str(), SFM_WRITE, &fileInfo);
-     if (!outFile)
-     {
-          cerr << "Error opening output file: " << sf_strerror(NULL) << endl;
-          exit(1);
-     }
-     sf_count_t numFrames = sf_writef_float(outFile, data.data(), originalFrames);
-     if (numFrames != originalFrames)
-     {
-          cerr << "Error writing frames to file." << endl;
-          sf_close(outFile);
-          exit(1);
-     }
-
-     sf_close(outFile);
-     auto end = chrono::high_resolution_clock::now();
-
-     cout << "    Successfully wrote " << numFrames << " frames to " << outputFile << endl;
-     cout << "    Writing time: "
-          << chrono::duration_cast<chrono::microseconds>(end - start).count()
-          << " microseconds\n"
-          << endl;
-}
-
-void *processBandpassFilterChunk(void *arg)
+int main(int argc, char *argv[])
 {
-     BandpassThreadData *threadData = (BandpassThreadData *)arg;
-     vector<float> &data = threadData->data;
-     vector<float> &filtered = threadData->filtered;
-     float sampleRate = threadData->sampleRate;
-     float bandwidth = threadData->bandwidth;
-
-     for (size_t i = threadData->startIdx; i < threadData->endIdx; ++i)
-     {
-          float t = static_cast<float>(i) / sampleRate;
-          float freq = (t > 0) ? 1.0f / t : 0.0f;
-          float deltaF = bandwidth;
-          float h = (freq * freq) / (freq * freq + deltaF * deltaF);
-          filtered[i] = h * data[i];
+     if (argc == 3 && string(argv[1]) == "--verify")
+          return runVerify(argv[2], false);
+     if (argc == 3 && string(argv[1]) == "--record-baseline")
+          return runVerify(argv[2], true);
+     if (argc == 3 && string(argv[1]) == "--daemon")
+          return runDaemon(argv[2]);
+
+     string checkpointFile, traceFile, equalizer, outputFormat = "wav";
+     size_t numShards = 0, decimation = 0;
+     bool restoreRate = false;
+     bool validArgs = argc >= 2 && argc % 2 == 0;
+     for (int i = 2; validArgs && i < argc; i += 2)
+     {
+          string option = argv[i];
+          if (option == "--incremental")
+               checkpointFile = argv[i + 1];
+          else if (option == "--memory-budget" && atoi(argv[i + 1]) > 0)
+               setMemoryBudget(static_cast<size_t>(atoi(argv[i + 1])) << 20);
+          else if (option == "--iir" && (string(argv[i + 1]) == "exact" || string(argv[i + 1]) == "fast"))
+          {
+               if (string(argv[i + 1]) == "fast")
+                    enableFastIIR();
+          }
+          else if (option == "--policy" && string(argv[i + 1]) == "sequential")
+               setExecutionPolicy(SEQUENTIAL_POLICY);
+          else if (option == "--policy" && string(argv[i + 1]) == "parallel")
+               setExecutionPolicy(PARALLEL_POLICY);
+          else if (option == "--trace")
+               traceFile = argv[i + 1];
+          else if (option == "--format" && (string(argv[i + 1]) == "wav" || string(argv[i + 1]) == "flac"))
+               outputFormat = argv[i + 1];
+          else if (option == "--spectral")
+               equalizer = argv[i + 1];
+          else if (option == "--shards" && atoi(argv[i + 1]) > 0)
+               numShards = atoi(argv[i + 1]);
+          else if ((option == "--decimate" || option == "--resample") && atoi(argv[i + 1]) > 1)
+          {
+               decimation = atoi(argv[i + 1]);
+               restoreRate = option == "--resample";
+          }
+          else
+               validArgs = false;
      }
+     validArgs = validArgs && !(numShards > 0 && !checkpointFile.empty());
+     validArgs = validArgs && !(decimation > 0 && (numShards > 0 || !checkpointFile.empty()));
+     validArgs = validArgs && !(!equalizer.empty() && (numShards > 0 || !checkpointFile.empty()));
+     validArgs = validArgs && !(outputFormat == "flac" && !checkpointFile.empty());
 
-     return nullptr;
-}
-
-void applyBandPassFilter(vector<float> &data, float sampleRate, float bandwidth)
-{
-     auto start = chrono::high_resolution_clock::now();
-
-     auto step1_start = chrono::high_resolution_clock::now();
-     vector<float> filtered(data.size());
-     auto step1_end = chrono::high_resolution_clock::now();
+     vector<float> eqFrequencies, eqGainsDb;
+     validArgs = validArgs && (equalizer.empty() || parseEqualizer(equalizer, eqFrequencies, eqGainsDb));
 
-     int numThreads = 4;
-     pthread_t threads[numThreads];
-     BandpassThreadData *threadData[numThreads];
-
-     size_t chunkSize = data.size() / numThreads;
-
-     auto step2_start = chrono::high_resolution_clock::now();
-
-     for (int i = 0; i < numThreads; ++i)
-     {
-          threadData[i] = new BandpassThreadData(data, filtered, sampleRate, bandwidth, i * chunkSize, (i == numThreads - 1) ? data.size() : (i + 1) * chunkSize);
-          pthread_create(&threads[i], nullptr, processBandpassFilterChunk, (void *)threadData[i]);
-     }
-
-     for (int i = 0; i < numThreads; ++i)
+     if (!validArgs)
      {
-          pthread_join(threads[i], nullptr);
-          delete threadData[i];
+          cerr << "Usage: " << argv[0] << " <input_file> [--incremental <checkpoint_file> | --shards <count> | --decimate <factor> | --resample <factor>]" << endl;
+          cerr << "       " << string(strlen(argv[0]), ' ') << " [--spectral <flat | hz:db,hz:db,...>] [--format <wav | flac>] [--trace <trace_file>]" << endl;
+          cerr << "       " << string(strlen(argv[0]), ' ') << " [--memory-budget <megabytes>] [--iir <exact | fast>] [--policy <sequential | parallel>]" << endl;
+          cerr << "       " << argv[0] << " --daemon <socket_path>" << endl;
+          cerr << "       " << argv[0] << " --verify <baseline_file> | --record-baseline <baseline_file>" << endl;
+          return 1;
      }
 
-     auto step2_end = chrono::high_resolution_clock::now();
-
-     auto step3_start = chrono::high_resolution_clock::now();
-     data = filtered;
-     auto step3_end = chrono::high_resolution_clock::now();
-
-     auto end = chrono::high_resolution_clock::now();
-
-     cout << "Bandpass Filtering time: " << endl;
-     cout << "    Step 1 (Initialization): "
-          << chrono::duration_cast<chrono::microseconds>(step1_end - step1_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Step 2 (Processing): "
-          << chrono::duration_cast<chrono::microseconds>(step2_end - step2_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Step 3 (Copy Data Back): "
-          << chrono::duration_cast<chrono::microseconds>(step3_end - step3_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Total Filtering Time: "
-          << chrono::duration_cast<chrono::microseconds>(end - start).count()
-          << " microseconds" << endl;
-}
-
-void *processNotchChunk(void *arg)
-{
-     NotchThreadData *threadData = (NotchThreadData *)arg;
-     vector<float> &data = threadData->data;
-     vector<float> &filtered = threadData->filtered;
-     float sampleRate = threadData->sampleRate;
-     float notchFreq = threadData->notchFreq;
-     int order = threadData->order;
+     string inputFile = argv[1];
+     if (!traceFile.empty())
+          startTrace(traceFile);
+     if (numShards > 0)
+          return runSharded(inputFile, numShards, outputFormat);
+
+     FilterCheckpoint checkpoint = {0, 0, 0, {}, {}, {}};
+     bool resumed = !checkpointFile.empty() && loadCheckpoint(checkpointFile, checkpoint);
+     size_t startFrame = checkpoint.processedFrames;
+
+     // A growing recording is read once so that every filter consumes the
+     // same frame range even if more audio is appended while we run.
+     SF_INFO fileInfo;
+     vector<float> audioData;
 
-     for (size_t i = threadData->startIdx; i < threadData->endIdx; ++i)
+     memset(&fileInfo, 0, sizeof(fileInfo));
      {
-          float t = static_cast<float>(i) / sampleRate;
-          float freq = (t > 0) ? 1.0f / t : 0.0f;
-          float h = 1.0f / (pow(freq / notchFreq, 2 * order) + 1);
-          filtered[i] = h * data[i];
+          MemoryStage memory("read");
+          if (!readWavFile(inputFile, audioData, fileInfo, startFrame))
+               return 1;
+          memory.report();
      }
 
-     return nullptr;
-}
-
-void applyNotchFilter(vector<float> &data, float sampleRate, float notchFreq, int order)
-{
-     auto start = chrono::high_resolution_clock::now();
-
-     auto step1_start = chrono::high_resolution_clock::now();
-     vector<float> filtered(data.size());
-     auto step1_end = chrono::high_resolution_clock::now();
-
-     int numThreads = 4;
-     pthread_t threads[numThreads];
-     NotchThreadData *threadData[numThreads];
-
-     size_t chunkSize = data.size() / numThreads;
-
-     auto step2_start = chrono::high_resolution_clock::now();
-     for (int i = 0; i < numThreads; ++i)
+     if (outputFormat == "flac" && !checkFlacInput(inputFile, fileInfo))
+          return 1;
+     if (resumed && (checkpoint.channels != fileInfo.channels || checkpoint.samplerate != fileInfo.samplerate))
      {
-          threadData[i] = new NotchThreadData(data, filtered, sampleRate, notchFreq, order, i * chunkSize, (i == numThreads - 1) ? data.size() : (i + 1) * chunkSize);
-          pthread_create(&threads[i], nullptr, processNotchChunk, (void *)threadData[i]);
+          cerr << "Checkpoint " << checkpointFile << " does not match the format of " << inputFile << endl;
+          return 1;
      }
-
-     for (int i = 0; i < numThreads; ++i)
+     if (resumed && audioData.empty())
      {
-          pthread_join(threads[i], nullptr);
-          delete threadData[i];
+          cout << "No new frames since checkpoint at frame " << startFrame << endl;
+          return 0;
      }
 
-     auto step2_end = chrono::high_resolution_clock::now();
-
-     auto step3_start = chrono::high_resolution_clock::now();
-     data = filtered;
-     auto step3_end = chrono::high_resolution_clock::now();
+     size_t origin = startFrame * fileInfo.channels;
 
-     auto end = chrono::high_resolution_clock::now();
-
-     cout << "Notch Filtering time: " << endl;
-     cout << "    Step 1 (Initialization): "
-          << chrono::duration_cast<chrono::microseconds>(step1_end - step1_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Step 2 (Processing): "
-          << chrono::duration_cast<chrono::microseconds>(step2_end - step2_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Step 3 (Copy Data Back): "
-          << chrono::duration_cast<chrono::microseconds>(step3_end - step3_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Total Filtering Time: "
-          << chrono::duration_cast<chrono::microseconds>(end - start).count()
-          << " microseconds" << endl;
-}
-
-void *processFIRChunk(void *arg)
-{
-     FIRThreadData *threadData = (FIRThreadData *)arg;
-     const vector<float> &data = threadData->data;
-     const vector<float> &coefficients = threadData->coefficients;
-     vector<float> &filtered = threadData->filtered;
-     size_t filterLength = coefficients.size();
-
-     for (size_t i = threadData->startIdx; i < threadData->endIdx; ++i)
+     // Filters run at the decimated rate; with --resample every output is
+     // brought back to the input rate and length before it is stored.
+     SF_INFO filterInfo = fileInfo;
+     if (decimation > 0)
      {
-          for (size_t j = 0; j < filterLength; ++j)
-          {
-               if (i >= j)
-               {
-                    filtered[i] += coefficients[j] * data[i - j];
-               }
-          }
+          MemoryStage memory("decimate");
+          decimateAudio(audioData, filterInfo, decimation);
+          memory.report();
      }
 
-     return nullptr;
-}
-
-void applyFIRFilter(vector<float> &data, const vector<float> &coefficients)
-{
-     auto start = chrono::high_resolution_clock::now();
-
-     auto step1_start = chrono::high_resolution_clock::now();
-     vector<float> filtered(data.size(), 0.0f);
-     auto step1_end = chrono::high_resolution_clock::now();
-
-     int numThreads = 4;
-     pthread_t threads[numThreads];
-     FIRThreadData *threadData[numThreads];
-
-     size_t chunkSize = data.size() / numThreads;
-
-     auto step2_start = chrono::high_resolution_clock::now();
-
-     for (int i = 0; i < numThreads; ++i)
+     auto finishOutput = [&](const string &outputFile, vector<float> &data)
      {
-          threadData[i] = new FIRThreadData(data, coefficients, filtered, i * chunkSize,
-                                            (i == numThreads - 1) ? data.size() : (i + 1) * chunkSize);
-          pthread_create(&threads[i], nullptr, processFIRChunk, (void *)threadData[i]);
-     }
+          SF_INFO outputInfo = filterInfo;
+          if (restoreRate)
+               interpolateAudio(data, outputInfo, decimation, fileInfo);
+          return storeOutput(formatOutputFile(outputFile, outputFormat), data, outputInfo, startFrame);
+     };
 
-     for (int i = 0; i < numThreads; ++i)
+     // Each stage's copy of the input is released when the stage ends
+     // rather than living until main returns.
      {
-          pthread_join(threads[i], nullptr);
-          delete threadData[i];
+          MemoryStage memory("bandpass");
+          vector<float> audioDataBandpass = audioData;
+          applyBandPassFilter(audioDataBandpass, filterInfo.samplerate, BANDPASS_BANDWIDTH, origin);
+          if (!finishOutput(BANDPASS_OUTPUT_FILE, audioDataBandpass))
+               return 1;
+          memory.report();
      }
 
-     auto step2_end = chrono::high_resolution_clock::now();
-
-     auto step3_start = chrono::high_resolution_clock::now();
-     data = filtered;
-     auto step3_end = chrono::high_resolution_clock::now();
-
-     auto end = chrono::high_resolution_clock::now();
-
-     cout << "FIR Filtering time: " << endl;
-     cout << "    Step 1 (Initialization): "
-          << chrono::duration_cast<chrono::microseconds>(step1_end - step1_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Step 2 (Convolution Loop): "
-          << chrono::duration_cast<chrono::microseconds>(step2_end - step2_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Step 3 (Copy Data Back): "
-          << chrono::duration_cast<chrono::microseconds>(step3_end - step3_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Total Filtering Time: "
-          << chrono::duration_cast<chrono::microseconds>(end - start).count()
-          << " microseconds" << endl;
-}
-
-void *computeFeedforward(void *arg)
-{
-     IIRThreadData *args = (IIRThreadData *)arg;
-
-     for (size_t i = args->start; i < args->end; ++i)
      {
-          for (size_t j = 0; j < args->feedforward->size(); ++j)
-          {
-               if (i >= j)
-               {
-                    (*args->partialResults)[i] += (*args->feedforward)[j] * (*args->data)[i - j];
-               }
-          }
+          MemoryStage memory("notch");
+          vector<float> audioDataNotch = audioData;
+          applyNotchFilter(audioDataNotch, filterInfo.samplerate, NOTCH_FREQUENCY, NOTCH_ORDER, origin);
+          if (!finishOutput(NOTCH_OUTPUT_FILE, audioDataNotch))
+               return 1;
+          memory.report();
      }
 
-     pthread_exit(nullptr);
-}
-
-void applyIIRFilter(vector<float> &data, const vector<float> &feedforward, const vector<float> &feedback)
-{
-     auto start = chrono::high_resolution_clock::now();
-
-     auto step1_start = chrono::high_resolution_clock::now();
-     vector<float> filtered(data.size(), 0.0f);
-     auto step1_end = chrono::high_resolution_clock::now();
-
-     auto step2a_start = chrono::high_resolution_clock::now();
-
-     size_t numThreads = 4; 
-     vector<pthread_t> threads(numThreads);
-     vector<IIRThreadData> threadArgs(numThreads);
-
-     size_t chunkSize = data.size() / numThreads;
-
-     for (size_t i = 0; i < numThreads; ++i)
      {
-          size_t startIdx = i * chunkSize;
-          size_t endIdx = (i == numThreads - 1) ? data.size() : startIdx + chunkSize;
-
-          threadArgs[i] = {&data, &feedforward, &filtered, startIdx, endIdx};
-          if (pthread_create(&threads[i], nullptr, computeFeedforward, &threadArgs[i]) != 0)
-          {
-               cerr << "Error creating thread " << i << endl;
-               exit(1);
-          }
+          MemoryStage memory("fir");
+          vector<float> audioDataFIR = audioData;
+          applyFIRFilter(audioDataFIR, FIR_COEFFICIENTS, checkpoint.firHistory);
+          if (!finishOutput(FIR_OUTPUT_FILE, audioDataFIR))
+               return 1;
+          memory.report();
      }
 
-     for (size_t i = 0; i < numThreads; ++i)
+     if (!equalizer.empty())
      {
-          pthread_join(threads[i], nullptr);
+          MemoryStage memory("spectral");
+          vector<float> audioDataSpectral = audioData;
+          applySpectralFilter(audioDataSpectral, filterInfo.channels, filterInfo.samplerate, BANDPASS_BANDWIDTH,
+                              NOTCH_FREQUENCY, NOTCH_ORDER, eqFrequencies, eqGainsDb);
+          if (!finishOutput(SPECTRAL_OUTPUT_FILE, audioDataSpectral))
+               return 1;
+          memory.report();
      }
 
-     auto step2a_end = chrono::high_resolution_clock::now();
-
-     auto step2b_start = chrono::high_resolution_clock::now();
-
-     for (size_t i = 0; i < data.size(); ++i)
      {
-          for (size_t j = 1; j < feedback.size(); ++j)
-          {
-               if (i >= j)
-               {
-                    filtered[i] -= feedback[j] * filtered[i - j];
-               }
-          }
+          MemoryStage memory("iir");
+          applyIIRFilter(audioData, IIR_FEEDFORWARD, IIR_FEEDBACK, checkpoint.iirInputHistory, checkpoint.iirOutputHistory);
+          if (!finishOutput(IIR_OUTPUT_FILE, audioData))
+               return 1;
+          memory.report();
      }
 
-     auto step2b_end = chrono::high_resolution_clock::now();
-
-     auto step3_start = chrono::high_resolution_clock::now();
-     data = filtered;
-     auto step3_end = chrono::high_resolution_clock::now();
-
-     auto end = chrono::high_resolution_clock::now();
-
-     cout << "IIR Filtering Time: " << endl;
-
-     cout << "    Step 1 (Initialization): "
-          << chrono::duration_cast<chrono::microseconds>(step1_end - step1_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Step 2a (Feedforward computation): "
-          << chrono::duration_cast<chrono::microseconds>(step2a_end - step2a_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Step 2b (Feedback computation): "
-          << chrono::duration_cast<chrono::microseconds>(step2b_end - step2b_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Step 3 (Copy Data Back): "
-          << chrono::duration_cast<chrono::microseconds>(step3_end - step3_start).count()
-          << " microseconds" << endl;
-
-     cout << "    Total Filtering Time: "
-          << chrono::duration_cast<chrono::microseconds>(end - start).count()
-          << " microseconds" << endl;
-}
-
-int main(int argc, char *argv[])
-{
-     if (argc != 2)
+     if (!checkpointFile.empty())
      {
-          cerr << "Usage: " << argv[0] << " <input_file>" << endl;
-          return 1;
+          checkpoint.processedFrames = fileInfo.frames;
+          checkpoint.channels = fileInfo.channels;
+          checkpoint.samplerate = fileInfo.samplerate;
+          saveCheckpoint(checkpointFile, checkpoint);
+          cout << "Checkpoint saved at frame " << checkpoint.processedFrames << " to " << checkpointFile << endl;
      }
 
-     string inputFile = argv[1];
-
-     string bandpassFilterOutputFile = "output_bandpass_filtered.wav";
-     string notchFilterOutputFile = "output_notch_filtered.wav";
-     string firFilterOutputFile = "output_fir_filtered.wav";
-     string iirFilterOutputFile = "output_iir_filtered.wav";
-
-     SF_INFO bandpassFilterFileInfo, notchFilterFileInfo, FIRFilterFileInfo, IIRFilterFileInfo;
-     vector<float> audioData;
-
-     memset(&bandpassFilterFileInfo, 0, sizeof(bandpassFilterFileInfo));
-     readWavFile(inputFile, audioData, bandpassFilterFileInfo);
-     vector<float> audioDataBandpass = audioData;
-     float bandwidth = 100.0f;
-     applyBandPassFilter(audioDataBandpass, bandpassFilterFileInfo.samplerate, bandwidth);
-     writeWavFile(bandpassFilterOutputFile, audioDataBandpass, bandpassFilterFileInfo);
-
-     memset(&notchFilterFileInfo, 0, sizeof(notchFilterFileInfo));
-     readWavFile(inputFile, audioData, notchFilterFileInfo);
-     vector<float> audioDataNotch = audioData;
-     float notchFreq = 1000.0f;
-     int order = 2;
-     applyNotchFilter(audioDataNotch, notchFilterFileInfo.samplerate, notchFreq, order);
-     writeWavFile(notchFilterOutputFile, audioDataNotch, notchFilterFileInfo);
-
-     memset(&FIRFilterFileInfo, 0, sizeof(FIRFilterFileInfo));
-     readWavFile(inputFile, audioData, FIRFilterFileInfo);
-     vector<float> audioDataFIR = audioData;
-     vector<float> firCoefficients = {0.1, 0.15, 0.5, 0.15, 0.1};
-     applyFIRFilter(audioData, firCoefficients);
-     writeWavFile(firFilterOutputFile, audioData, FIRFilterFileInfo);
-
-     memset(&IIRFilterFileInfo, 0, sizeof(IIRFilterFileInfo));
-     readWavFile(inputFile, audioData, IIRFilterFileInfo);
-     vector<float> iirFeedforward = {0.5, 0.25};
-     vector<float> iirFeedback = {1.0, -0.75};
-     applyIIRFilter(audioData, iirFeedforward, iirFeedback);
-     writeWavFile(iirFilterOutputFile, audioData, IIRFilterFileInfo);
-
      return 0;
 }
@@ -0,0 +1,197 @@
+#include "memory.h"
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "types.h"
+
+using namespace std;
+
+static atomic<size_t> liveBytes(0);
+static atomic<size_t> allocatedBytes(0);
+static atomic<size_t> liveBuffers(0);
+static atomic<size_t> peakBuffers(0);
+static atomic<size_t> budgetBytes(0);
+static atomic<const char *> currentStage("startup");
+
+static double megabytes(size_t bytes)
+{
+     return bytes / (1024.0 * 1024.0);
+}
+
+// Runs inside operator new, often on a pool worker, so it reports with stdio
+// only and leaves with _exit: exit would run static destructors, including
+// the worker pool's, while its threads are still running. The budget is
+// dropped first so that only one thread reports.
+static void exceedBudget(size_t requested, const char *what)
+{
+     size_t budget = budgetBytes.exchange(0);
+     if (budget == 0)
+          return;
+     fprintf(stderr, "Memory budget of %.1f MB exceeded in %s: %.1f MB requested with %.1f MB already in use\n",
+             megabytes(budget), what, megabytes(requested), megabytes(liveBytes.load()));
+     _exit(1);
+}
+
+void reserveMemory(size_t bytes, const char *what)
+{
+     size_t budget = budgetBytes.load();
+     if (budget > 0 && liveBytes.load() + bytes > budget)
+          exceedBudget(bytes, what);
+     liveBytes += bytes;
+     allocatedBytes += bytes;
+}
+
+void releaseMemory(size_t bytes)
+{
+     liveBytes -= bytes;
+}
+
+static void countAllocation(void *pointer)
+{
+     size_t bytes = malloc_usable_size(pointer);
+     liveBytes += bytes;
+     allocatedBytes += bytes;
+     if (bytes >= MEMORY_BUFFER_THRESHOLD)
+     {
+          size_t buffers = ++liveBuffers;
+          size_t peak = peakBuffers.load();
+          while (buffers > peak && !peakBuffers.compare_exchange_weak(peak, buffers))
+               ;
+     }
+}
+
+static void countRelease(void *pointer)
+{
+     size_t bytes = malloc_usable_size(pointer);
+     liveBytes -= bytes;
+     if (bytes >= MEMORY_BUFFER_THRESHOLD)
+          --liveBuffers;
+}
+
+static void *allocate(size_t size)
+{
+     size_t budget = budgetBytes.load();
+     if (budget > 0 && liveBytes.load() + size > budget)
+          exceedBudget(size, currentStage.load());
+
+     void *pointer = malloc(size == 0 ? 1 : size);
+     if (pointer)
+          countAllocation(pointer);
+     return pointer;
+}
+
+static void deallocate(void *pointer)
+{
+     if (!pointer)
+          return;
+     countRelease(pointer);
+     free(pointer);
+}
+
+void *operator new(size_t size)
+{
+     void *pointer = allocate(size);
+     if (!pointer)
+          throw bad_alloc();
+     return pointer;
+}
+
+void *operator new[](size_t size)
+{
+     return operator new(size);
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+     return allocate(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+     return allocate(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+     deallocate(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+     deallocate(pointer);
+}
+
+void operator delete(void *pointer, const nothrow_t &) noexcept
+{
+     deallocate(pointer);
+}
+
+void operator delete[](void *pointer, const nothrow_t &) noexcept
+{
+     deallocate(pointer);
+}
+
+void setMemoryBudget(size_t bytes)
+{
+     budgetBytes = bytes;
+}
+
+size_t liveHeapBytes()
+{
+     return liveBytes.load();
+}
+
+static size_t residentBytes()
+{
+     long pages = 0, resident = 0;
+     FILE *statm = fopen("/proc/self/statm", "r");
+     if (!statm)
+          return 0;
+     if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+          resident = 0;
+     fclose(statm);
+     return resident * sysconf(_SC_PAGESIZE);
+}
+
+static size_t peakResidentBytes()
+{
+     struct rusage usage;
+     getrusage(RUSAGE_SELF, &usage);
+     return usage.ru_maxrss * 1024;
+}
+
+MemoryStage::MemoryStage(const char *name)
+    : name(name), outerName(currentStage.load()), allocatedBefore(allocatedBytes.load()),
+      outerPeakBuffers(peakBuffers.exchange(liveBuffers.load())), rssBefore(residentBytes())
+{
+     currentStage = name;
+}
+
+MemoryStage::~MemoryStage()
+{
+     size_t peak = peakBuffers.load();
+     while (outerPeakBuffers > peak && !peakBuffers.compare_exchange_weak(peak, outerPeakBuffers))
+          ;
+     currentStage = outerName;
+}
+
+void MemoryStage::report() const
+{
+     ios::fmtflags flags = cout.flags();
+     streamsize precision = cout.precision();
+     cout << fixed << setprecision(1)
+          << "    Memory (" << name << "): " << megabytes(allocatedBytes.load() - allocatedBefore) << " MB allocated, "
+          << liveBuffers.load() << " live buffers (peak " << peakBuffers.load() << "), RSS "
+          << megabytes(rssBefore) << " -> " << megabytes(residentBytes()) << " MB (peak "
+          << megabytes(peakResidentBytes()) << " MB)\n"
+          << endl;
+     cout.flags(flags);
+     cout.precision(precision);
+}
@@ -0,0 +1,38 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+// Heap accounting. Every operator new/delete in the process is counted;
+// allocations of at least MEMORY_BUFFER_THRESHOLD bytes count as buffers.
+// With a budget set, an allocation that would push live heap bytes past it
+// stops the process with a message naming the stage that asked for it.
+void setMemoryBudget(size_t bytes);
+size_t liveHeapBytes();
+
+// Reserves memory that is not allocated through operator new (shared
+// mappings) against the same budget.
+void reserveMemory(size_t bytes, const char *what);
+void releaseMemory(size_t bytes);
+
+// Samples the counters and RSS when constructed; report() prints what the
+// stage allocated, the peak live buffer count while it ran and how RSS moved.
+class MemoryStage
+{
+public:
+     explicit MemoryStage(const char *name);
+     ~MemoryStage();
+     void report() const;
+
+private:
+     const char *name;
+     const char *outerName;
+     size_t allocatedBefore;
+     size_t outerPeakBuffers;
+     size_t rssBefore;
+};
+
+#endif
@@ -0,0 +1,215 @@
+#include "shard.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <sndfile.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "types.h"
+#include "filters.h"
+#include "voicefilters.h"
+#include "memory.h"
+#include "flac.h"
+
+using namespace std;
+
+// The IIR recursion of a slice starts this many samples early from a zero
+// state. For a stable filter the start-up error decays geometrically with
+// the pole radius (0.75^4096 for the default design), so the slice output
+// matches a single-process run to float precision.
+static const size_t IIR_WARMUP_SAMPLES = 4096;
+static const int MAX_SHARD_ATTEMPTS = 3;
+
+enum ShardOutput
+{
+     BANDPASS_OUTPUT,
+     NOTCH_OUTPUT,
+     FIR_OUTPUT,
+     IIR_OUTPUT,
+     NUM_SHARD_OUTPUTS
+};
+
+static float *mapShared(size_t samples)
+{
+     size_t bytes = max<size_t>(1, samples) * sizeof(float);
+     reserveMemory(bytes, "shared shard buffers");
+     void *mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+     if (mapping == MAP_FAILED)
+     {
+          releaseMemory(bytes);
+          return nullptr;
+     }
+     return static_cast<float *>(mapping);
+}
+
+static void unmapShared(float *mapping, size_t samples)
+{
+     if (!mapping)
+          return;
+     munmap(mapping, max<size_t>(1, samples) * sizeof(float));
+     releaseMemory(max<size_t>(1, samples) * sizeof(float));
+}
+
+// The count input samples immediately before position, zero before the
+// start of the file.
+static vector<float> precedingSamples(const float *input, size_t position, size_t count)
+{
+     vector<float> samples(count, 0.0f);
+     for (size_t k = 0; k < count; ++k)
+          if (position + k >= count)
+               samples[k] = input[position + k - count];
+     return samples;
+}
+
+static void filterShard(const float *input, float *const *outputs, size_t start, size_t end, float sampleRate)
+{
+     vf_view in = {input + start, end - start, 1};
+
+     vf_buffer bandpass = {outputs[BANDPASS_OUTPUT] + start, end - start, 1};
+     vf_bandpass(in, bandpass, sampleRate, BANDPASS_BANDWIDTH, start, nullptr);
+
+     vf_buffer notch = {outputs[NOTCH_OUTPUT] + start, end - start, 1};
+     vf_notch(in, notch, sampleRate, NOTCH_FREQUENCY, NOTCH_ORDER, start, nullptr);
+
+     vector<float> firHistory = precedingSamples(input, start, FIR_COEFFICIENTS.size() - 1);
+     vf_buffer fir = {outputs[FIR_OUTPUT] + start, end - start, 1};
+     vf_fir(in, fir, FIR_COEFFICIENTS.data(), FIR_COEFFICIENTS.size(), firHistory.data(), nullptr);
+
+     size_t warmupStart = start > IIR_WARMUP_SAMPLES ? start - IIR_WARMUP_SAMPLES : 0;
+     vector<float> inputHistory = precedingSamples(input, warmupStart, IIR_FEEDFORWARD.size() - 1);
+     vector<float> outputHistory(IIR_FEEDBACK.size() - 1, 0.0f);
+     vector<float> warmup(start - warmupStart);
+     vf_view warmupIn = {input + warmupStart, warmup.size(), 1};
+     vf_buffer warmupOut = {warmup.data(), warmup.size(), 1};
+     vf_iir(warmupIn, warmupOut, IIR_FEEDFORWARD.data(), IIR_FEEDFORWARD.size(), IIR_FEEDBACK.data(), IIR_FEEDBACK.size(),
+            inputHistory.data(), outputHistory.data(), nullptr);
+
+     vf_buffer iir = {outputs[IIR_OUTPUT] + start, end - start, 1};
+     vf_iir(in, iir, IIR_FEEDFORWARD.data(), IIR_FEEDFORWARD.size(), IIR_FEEDBACK.data(), IIR_FEEDBACK.size(),
+            inputHistory.data(), outputHistory.data(), nullptr);
+}
+
+static pid_t launchShard(const float *input, float *const *outputs, size_t start, size_t end, float sampleRate)
+{
+     cout << flush;
+     pid_t pid = fork();
+     if (pid == 0)
+     {
+          // The child shares no threads with the parent's worker pool, so it
+          // filters serially and leaves without running static destructors.
+          filterShard(input, outputs, start, end, sampleRate);
+          _exit(0);
+     }
+     return pid;
+}
+
+int runSharded(const string &inputFile, size_t numShards, const string &outputFormat)
+{
+     SF_INFO fileInfo;
+     memset(&fileInfo, 0, sizeof(fileInfo));
+     if (!probeWavFile(inputFile, fileInfo))
+          return 1;
+     if (outputFormat == "flac" && !checkFlacInput(inputFile, fileInfo))
+          return 1;
+
+     size_t samples = fileInfo.frames * fileInfo.channels;
+     float *input = mapShared(samples);
+     float *outputs[NUM_SHARD_OUTPUTS];
+     bool mapped = input != nullptr;
+     for (int i = 0; i < NUM_SHARD_OUTPUTS; ++i)
+     {
+          outputs[i] = mapShared(samples);
+          mapped = mapped && outputs[i];
+     }
+
+     int status = 0;
+     if (!mapped)
+     {
+          cerr << "Error mapping shared buffers for " << samples << " samples." << endl;
+          status = 1;
+     }
+     else if (!readWavFrames(inputFile, input, fileInfo, 0))
+     {
+          status = 1;
+     }
+
+     if (status == 0)
+     {
+          auto start = chrono::high_resolution_clock::now();
+
+          numShards = max<size_t>(1, min(numShards, samples));
+          vector<pid_t> pids(numShards);
+          vector<int> attempts(numShards, 1);
+          size_t running = 0;
+
+          for (size_t k = 0; k < numShards && status == 0; ++k)
+          {
+               pids[k] = launchShard(input, outputs, samples * k / numShards, samples * (k + 1) / numShards, fileInfo.samplerate);
+               if (pids[k] < 0)
+               {
+                    cerr << "Error forking shard " << k << endl;
+                    status = 1;
+               }
+               else
+               {
+                    ++running;
+               }
+          }
+
+          while (running > 0)
+          {
+               int exitStatus;
+               pid_t pid = wait(&exitStatus);
+               if (pid < 0)
+                    break;
+
+               size_t k = find(pids.begin(), pids.end(), pid) - pids.begin();
+               if (k == numShards)
+                    continue;
+               --running;
+
+               if (WIFEXITED(exitStatus) && WEXITSTATUS(exitStatus) == 0)
+                    continue;
+
+               cerr << "Shard " << k << " failed on attempt " << attempts[k] << endl;
+               if (status != 0 || attempts[k] >= MAX_SHARD_ATTEMPTS)
+               {
+                    status = 1;
+                    continue;
+               }
+
+               ++attempts[k];
+               pids[k] = launchShard(input, outputs, samples * k / numShards, samples * (k + 1) / numShards, fileInfo.samplerate);
+               if (pids[k] < 0)
+                    status = 1;
+               else
+                    ++running;
+          }
+
+          auto end = chrono::high_resolution_clock::now();
+          cout << "Sharded filtering time (" << numShards << " processes): "
+               << chrono::duration_cast<chrono::microseconds>(end - start).count()
+               << " microseconds\n"
+               << endl;
+     }
+
+     if (status == 0)
+     {
+          const string outputFiles[NUM_SHARD_OUTPUTS] = {BANDPASS_OUTPUT_FILE, NOTCH_OUTPUT_FILE, FIR_OUTPUT_FILE, IIR_OUTPUT_FILE};
+          for (int i = 0; i < NUM_SHARD_OUTPUTS && status == 0; ++i)
+          {
+               SF_INFO outputInfo = fileInfo;
+               if (!writeWavSamples(formatOutputFile(outputFiles[i], outputFormat), outputs[i], outputInfo))
+                    status = 1;
+          }
+     }
+
+     unmapShared(input, samples);
+     for (int i = 0; i < NUM_SHARD_OUTPUTS; ++i)
+          unmapShared(outputs[i], samples);
+     return status;
+}
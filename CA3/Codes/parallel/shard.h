@@ -0,0 +1,16 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+// Filters the input in numShards forked worker processes. The decoded input
+// and the four outputs live in shared mappings; each worker filters its own
+// slice, reading the FIR overlap and IIR warm-up region from the input, and
+// a worker that crashes is retried without redoing the other slices.
+// Outputs are written in outputFormat ("wav" or "flac").
+int runSharded(const string &inputFile, size_t numShards, const string &outputFormat);
+
+#endif
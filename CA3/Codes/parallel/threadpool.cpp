@@ -0,0 +1,130 @@
+#include "threadpool.h"
+
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+const size_t DEFAULT_POOL_THREADS = 4;
+
+ThreadPool::ThreadPool(size_t numThreads) : threads(numThreads), stopping(false)
+{
+     pthread_mutex_init(&mutex, nullptr);
+     pthread_cond_init(&workReady, nullptr);
+
+     for (size_t i = 0; i < numThreads; ++i)
+     {
+          if (pthread_create(&threads[i], nullptr, workerLoop, this) != 0)
+          {
+               cerr << "Error creating thread " << i << endl;
+               exit(1);
+          }
+     }
+}
+
+ThreadPool::~ThreadPool()
+{
+     pthread_mutex_lock(&mutex);
+     stopping = true;
+     pthread_cond_broadcast(&workReady);
+     pthread_mutex_unlock(&mutex);
+
+     for (size_t i = 0; i < threads.size(); ++i)
+          pthread_join(threads[i], nullptr);
+
+     pthread_cond_destroy(&workReady);
+     pthread_mutex_destroy(&mutex);
+}
+
+size_t ThreadPool::size() const
+{
+     return threads.size();
+}
+
+void ThreadPool::run(void *(*routine)(void *), void *const *args, size_t count)
+{
+     Batch batch;
+     batch.remaining = count;
+     pthread_cond_init(&batch.done, nullptr);
+
+     pthread_mutex_lock(&mutex);
+     for (size_t i = 0; i < count; ++i)
+     {
+          Task task = {routine, args[i], &batch};
+          tasks.push_back(task);
+     }
+     pthread_cond_broadcast(&workReady);
+
+     while (batch.remaining > 0)
+          pthread_cond_wait(&batch.done, &mutex);
+     pthread_mutex_unlock(&mutex);
+
+     pthread_cond_destroy(&batch.done);
+}
+
+void *ThreadPool::workerLoop(void *arg)
+{
+     ThreadPool *pool = static_cast<ThreadPool *>(arg);
+
+     pthread_mutex_lock(&pool->mutex);
+     while (true)
+     {
+          while (pool->tasks.empty() && !pool->stopping)
+               pthread_cond_wait(&pool->workReady, &pool->mutex);
+          if (pool->tasks.empty())
+               break;
+
+          Task task = pool->tasks.front();
+          pool->tasks.pop_front();
+          pthread_mutex_unlock(&pool->mutex);
+
+          task.routine(task.arg);
+
+          pthread_mutex_lock(&pool->mutex);
+          if (--task.batch->remaining == 0)
+               pthread_cond_signal(&task.batch->done);
+     }
+     pthread_mutex_unlock(&pool->mutex);
+
+     return nullptr;
+}
+
+ThreadPool &workerPool()
+{
+     static ThreadPool pool(DEFAULT_POOL_THREADS);
+     return pool;
+}
+
+static ExecutionPolicy currentPolicy = DEFAULT_EXECUTION_POLICY;
+
+void setExecutionPolicy(ExecutionPolicy policy)
+{
+     currentPolicy = policy;
+}
+
+ExecutionPolicy executionPolicy()
+{
+     return currentPolicy;
+}
+
+const char *executionPolicyName()
+{
+     return currentPolicy == SEQUENTIAL_POLICY ? "sequential" : "parallel";
+}
+
+// Number of chunks work should be split into under the current policy.
+size_t executionWidth()
+{
+     return currentPolicy == SEQUENTIAL_POLICY ? 1 : workerPool().size();
+}
+
+void runWithPolicy(void *(*routine)(void *), void *const *args, size_t count)
+{
+     if (currentPolicy == PARALLEL_POLICY)
+     {
+          workerPool().run(routine, args, count);
+          return;
+     }
+     for (size_t i = 0; i < count; ++i)
+          routine(args[i]);
+}
@@ -0,0 +1,72 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+// Fixed set of worker threads that stay alive between filter calls, so a
+// run pays thread creation once instead of once per stage.
+class ThreadPool
+{
+public:
+     explicit ThreadPool(size_t numThreads);
+     ~ThreadPool();
+
+     size_t size() const;
+
+     // Runs routine(args[i]) for every i on the workers and blocks until
+     // all of them have returned.
+     void run(void *(*routine)(void *), void *const *args, size_t count);
+
+private:
+     struct Batch
+     {
+          size_t remaining;
+          pthread_cond_t done;
+     };
+
+     struct Task
+     {
+          void *(*routine)(void *);
+          void *arg;
+          Batch *batch;
+     };
+
+     static void *workerLoop(void *arg);
+
+     vector<pthread_t> threads;
+     deque<Task> tasks;
+     pthread_mutex_t mutex;
+     pthread_cond_t workReady;
+     bool stopping;
+};
+
+ThreadPool &workerPool();
+
+// How filter work is executed. Under the sequential policy tasks run inline
+// on the calling thread, in order; under the parallel policy they go to
+// workerPool(). Filters produce the same output under either policy. The
+// default is fixed at compile time (the serial build passes
+// -DDEFAULT_EXECUTION_POLICY=SEQUENTIAL_POLICY) and can be changed at run
+// time.
+enum ExecutionPolicy
+{
+     SEQUENTIAL_POLICY,
+     PARALLEL_POLICY
+};
+
+#ifndef DEFAULT_EXECUTION_POLICY
+#define DEFAULT_EXECUTION_POLICY PARALLEL_POLICY
+#endif
+
+void setExecutionPolicy(ExecutionPolicy policy);
+ExecutionPolicy executionPolicy();
+const char *executionPolicyName();
+size_t executionWidth();
+void runWithPolicy(void *(*routine)(void *), void *const *args, size_t count);
+
+#endif
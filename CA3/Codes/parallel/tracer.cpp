@@ -0,0 +1,136 @@
+#include "tracer.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace std;
+
+struct TraceEvent
+{
+     const char *name;
+     const char *category;
+     int64_t beginNs;
+     int64_t endNs;
+     size_t firstIdx;
+     size_t lastIdx;
+};
+
+// Buffers are owned by the thread that fills them and are only published
+// through the registry, which is a lock-free push-only list. They are never
+// freed, so events from worker threads that already exited remain readable.
+struct TraceBuffer
+{
+     int tid;
+     vector<TraceEvent> events;
+     TraceBuffer *next;
+};
+
+static const size_t TRACE_BUFFER_RESERVE = 4096;
+
+static atomic<bool> enabled(false);
+static atomic<TraceBuffer *> registry(nullptr);
+static atomic<int> nextTid(1);
+static string outputFile;
+static chrono::steady_clock::time_point traceOrigin;
+static thread_local TraceBuffer *localBuffer = nullptr;
+
+static TraceBuffer *threadBuffer()
+{
+     if (!localBuffer)
+     {
+          localBuffer = new TraceBuffer();
+          localBuffer->tid = nextTid.fetch_add(1);
+          localBuffer->events.reserve(TRACE_BUFFER_RESERVE);
+          localBuffer->next = registry.load(memory_order_relaxed);
+          while (!registry.compare_exchange_weak(localBuffer->next, localBuffer, memory_order_release, memory_order_relaxed))
+               ;
+     }
+     return localBuffer;
+}
+
+static void writeTrace()
+{
+     if (!enabled.exchange(false))
+          return;
+
+     ofstream out(outputFile);
+     if (!out)
+     {
+          cerr << "Error opening trace file: " << outputFile << endl;
+          return;
+     }
+
+     int pid = getpid();
+     size_t eventCount = 0;
+     out << fixed << setprecision(3);
+     out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+     bool first = true;
+     for (TraceBuffer *buffer = registry.load(memory_order_acquire); buffer; buffer = buffer->next)
+     {
+          out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+              << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":\""
+              << (buffer->tid == 1 ? "main" : "worker ") << (buffer->tid == 1 ? "" : to_string(buffer->tid)) << "\"}}";
+          first = false;
+
+          for (const TraceEvent &event : buffer->events)
+          {
+               out << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+                   << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+                   << ",\"ts\":" << event.beginNs / 1000.0
+                   << ",\"dur\":" << (event.endNs - event.beginNs) / 1000.0;
+               if (event.lastIdx > event.firstIdx)
+                    out << ",\"args\":{\"first\":" << event.firstIdx << ",\"last\":" << event.lastIdx << "}";
+               out << "}";
+               ++eventCount;
+          }
+     }
+     out << "\n]}\n";
+
+     cout << "Wrote " << eventCount << " trace events to " << outputFile << endl;
+}
+
+void startTrace(const string &traceFile)
+{
+     outputFile = traceFile;
+     traceOrigin = chrono::steady_clock::now();
+     threadBuffer();
+     enabled.store(true);
+     atexit(writeTrace);
+}
+
+bool traceEnabled()
+{
+     return enabled.load(memory_order_relaxed);
+}
+
+int64_t traceNow()
+{
+     return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - traceOrigin).count();
+}
+
+void traceEvent(const char *name, const char *category, int64_t beginNs, int64_t endNs, size_t firstIdx, size_t lastIdx)
+{
+     if (!traceEnabled())
+          return;
+
+     TraceEvent event = {name, category, beginNs, endNs, firstIdx, lastIdx};
+     threadBuffer()->events.push_back(event);
+}
+
+TraceScope::TraceScope(const char *name, const char *category, size_t firstIdx, size_t lastIdx)
+    : name(name), category(category), firstIdx(firstIdx), lastIdx(lastIdx), beginNs(traceEnabled() ? traceNow() : 0)
+{
+}
+
+TraceScope::~TraceScope()
+{
+     if (traceEnabled())
+          traceEvent(name, category, beginNs, traceNow(), firstIdx, lastIdx);
+}
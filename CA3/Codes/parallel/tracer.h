@@ -0,0 +1,33 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Optional timeline tracer. Each thread appends complete events to its own
+// buffer without locking; the buffers are written out as Chrome trace-event
+// JSON (chrome://tracing, Perfetto) when the process exits.
+void startTrace(const string &traceFile);
+bool traceEnabled();
+int64_t traceNow();
+void traceEvent(const char *name, const char *category, int64_t beginNs, int64_t endNs,
+                size_t firstIdx = 0, size_t lastIdx = 0);
+
+class TraceScope
+{
+public:
+     TraceScope(const char *name, const char *category, size_t firstIdx = 0, size_t lastIdx = 0);
+     ~TraceScope();
+
+private:
+     const char *name;
+     const char *category;
+     size_t firstIdx;
+     size_t lastIdx;
+     int64_t beginNs;
+};
+
+#endif
@@ -8,63 +8,90 @@
 #include <cstring>
 #include <cmath>
 #include <chrono>
+#include <cstdint>
 #include "types.h"
 
 using namespace std;
 
-struct ReadThreadArgs {
-    string inputFile;
-    vector<float>* data;
-    SF_INFO fileInfo;
-    size_t startFrame;
-    size_t numFrames;
-    size_t channels;
-};
+const string BANDPASS_OUTPUT_FILE = "output_bandpass_filtered.wav";
+const string NOTCH_OUTPUT_FILE = "output_notch_filtered.wav";
+const string FIR_OUTPUT_FILE = "output_fir_filtered.wav";
+const string IIR_OUTPUT_FILE = "output_iir_filtered.wav";
+const string SPECTRAL_OUTPUT_FILE = "output_spectral_filtered.wav";
 
-struct BandpassThreadData
-{
-     vector<float> &data;
-     vector<float> &filtered;
-     float sampleRate;
-     float bandwidth;
-     size_t startIdx;
-     size_t endIdx;
-
-     BandpassThreadData(vector<float> &data, vector<float> &filtered, float sampleRate, float bandwidth, size_t startIdx, size_t endIdx)
-         : data(data), filtered(filtered), sampleRate(sampleRate), bandwidth(bandwidth), startIdx(startIdx), endIdx(endIdx) {}
-};
+const int BANDPASS_FILTER = 0;
+const int NOTCH_FILTER = 1;
+
+const float BANDPASS_BANDWIDTH = 100.0f;
+const float NOTCH_FREQUENCY = 1000.0f;
+const int NOTCH_ORDER = 2;
+const vector<float> FIR_COEFFICIENTS = {0.1, 0.15, 0.5, 0.15, 0.1};
+const vector<float> IIR_FEEDFORWARD = {0.5, 0.25};
+const vector<float> IIR_FEEDBACK = {1.0, -0.75};
+
+const size_t RESAMPLER_TAPS_PER_PHASE = 24;
+const float RESAMPLER_PASSBAND = 0.9f;
+
+const size_t SPECTRAL_FRAME_SIZE = 1024;
 
-struct NotchThreadData
-{
-     vector<float> &data;
-     vector<float> &filtered;
-     float sampleRate;
-     float notchFreq;
-     int order;
-     size_t startIdx;
-     size_t endIdx;
-
-     NotchThreadData(vector<float> &data, vector<float> &filtered, float sampleRate, float notchFreq, int order, size_t startIdx, size_t endIdx)
-         : data(data), filtered(filtered), sampleRate(sampleRate), notchFreq(notchFreq), order(order), startIdx(startIdx), endIdx(endIdx) {}
+// Heap allocations at least this large are counted as buffers by the
+// memory accounting.
+const size_t MEMORY_BUFFER_THRESHOLD = 64 * 1024;
+
+// --verify: generated signal length, timing repetitions, and how far below
+// the recorded baseline throughput an engine may fall before failing.
+const size_t VERIFY_SAMPLES = 1 << 20;
+const int VERIFY_TIMING_RUNS = 9;
+const double VERIFY_THROUGHPUT_TOLERANCE = 0.4;
+
+// FLAC output: frames per encoded block and its frame-header code (4096).
+const size_t FLAC_BLOCK_SIZE = 4096;
+const int FLAC_BLOCK_SIZE_CODE = 12;
+
+// Frames converted per positioned read when loading uncompressed input.
+const size_t READ_SLAB_FRAMES = 65536;
+
+// Where an uncompressed WAV keeps its samples, found once at open time so
+// that every reader thread can pread its frames from one shared descriptor.
+struct WavLayout {
+    int fd;
+    int64_t dataOffset;
+    size_t sampleBytes;
+    bool isFloat;
+    size_t channels;
 };
 
-struct FIRThreadData {
-    const vector<float>& data;
-    const vector<float>& coefficients;
-    vector<float>& filtered;
-    size_t startIdx;
-    size_t endIdx;
+struct ReadThreadArgs {
+    const WavLayout* layout;
+    float* data;
+    size_t baseFrame;
+    size_t startFrame;
+    size_t numFrames;
+    bool ok;
+};
 
-    FIRThreadData(const vector<float>& data, const vector<float>& coefficients, vector<float>& filtered, size_t startIdx, size_t endIdx)
-        : data(data), coefficients(coefficients), filtered(filtered), startIdx(startIdx), endIdx(endIdx) {}
+// Filter state carried between runs over a growing recording. The history
+// vectors hold the last samples seen by each filter, oldest first, so a run
+// that starts at processedFrames continues exactly where the previous one
+// stopped. A zero-filled state reproduces a run from the start of the file.
+struct FilterCheckpoint {
+    size_t processedFrames;
+    int channels;
+    int samplerate;
+    vector<float> firHistory;
+    vector<float> iirInputHistory;
+    vector<float> iirOutputHistory;
 };
 
-struct IIRThreadData {
-    const vector<float> *data;
-    const vector<float> *feedforward;
-    vector<float> *partialResults;
-    size_t start;
-    size_t end;
+// Layout of a shared-memory audio buffer used by daemon jobs: this 24-byte
+// header ("VFSA", channels, samplerate, reserved, frames; native byte order)
+// followed by frames * channels interleaved float samples.
+struct SharedAudioHeader {
+    char magic[4];
+    int32_t channels;
+    int32_t samplerate;
+    int32_t reserved;
+    int64_t frames;
 };
 
 #endif
\ No newline at end of file
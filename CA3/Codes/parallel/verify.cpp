@@ -0,0 +1,396 @@
+#include "verify.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include "types.h"
+#include "filters.h"
+#include "voicefilters.h"
+#include "threadpool.h"
+
+using namespace std;
+
+static const float VERIFY_SAMPLE_RATE = 22050.0f;
+
+// The original serial VoiceFilters loops, kept as the reference every other
+// engine is compared against.
+static vector<float> referenceBandpass(const vector<float> &data, float sampleRate, float bandwidth)
+{
+     vector<float> filtered(data.size());
+     for (size_t i = 0; i < data.size(); ++i)
+     {
+          float t = static_cast<float>(i) / sampleRate;
+          float freq = (t > 0) ? 1.0f / t : 0.0f;
+          float h = (freq * freq) / (freq * freq + bandwidth * bandwidth);
+          filtered[i] = h * data[i];
+     }
+     return filtered;
+}
+
+static vector<float> referenceNotch(const vector<float> &data, float sampleRate, float notchFreq, int order)
+{
+     vector<float> filtered(data.size());
+     for (size_t i = 0; i < data.size(); ++i)
+     {
+          float t = static_cast<float>(i) / sampleRate;
+          float freq = (t > 0) ? 1.0f / t : 0.0f;
+          float h = 1.0f / (pow(freq / notchFreq, 2 * order) + 1);
+          filtered[i] = h * data[i];
+     }
+     return filtered;
+}
+
+static vector<float> referenceFIR(const vector<float> &data, const vector<float> &coefficients)
+{
+     vector<float> filtered(data.size(), 0.0f);
+     for (size_t i = 0; i < data.size(); ++i)
+          for (size_t j = 0; j < coefficients.size() && j <= i; ++j)
+               filtered[i] += coefficients[j] * data[i - j];
+     return filtered;
+}
+
+static vector<float> referenceIIR(const vector<float> &data, const vector<float> &feedforward, const vector<float> &feedback)
+{
+     vector<float> filtered(data.size(), 0.0f);
+     for (size_t i = 0; i < data.size(); ++i)
+     {
+          for (size_t j = 0; j < feedforward.size() && j <= i; ++j)
+               filtered[i] += feedforward[j] * data[i - j];
+          for (size_t j = 1; j < feedback.size() && j <= i; ++j)
+               filtered[i] -= feedback[j] * filtered[i - j];
+     }
+     return filtered;
+}
+
+static vector<float> referenceDecimate(const vector<float> &data, size_t factor, const vector<float> &taps)
+{
+     vector<float> decimated(vf_decimated_length(data.size(), factor));
+     for (size_t m = 0; m < decimated.size(); ++m)
+     {
+          double sum = 0.0;
+          for (size_t k = 0; k < taps.size() && k <= m * factor; ++k)
+               sum += double(taps[k]) * data[m * factor - k];
+          decimated[m] = static_cast<float>(sum);
+     }
+     return decimated;
+}
+
+static vector<float> referenceInterpolate(const vector<float> &data, size_t factor, const vector<float> &taps)
+{
+     vector<float> interpolated(data.size() * factor);
+     for (size_t n = 0; n < interpolated.size(); ++n)
+     {
+          double sum = 0.0;
+          for (size_t k = n % factor; k < taps.size() && k <= n; k += factor)
+               sum += double(taps[k]) * data[(n - k) / factor];
+          interpolated[n] = static_cast<float>(sum * factor);
+     }
+     return interpolated;
+}
+
+// Speech-like test signal: a chirp, two steady tones, white noise and a
+// fade to digital silence over the last eighth.
+static vector<float> generateSignal(size_t length)
+{
+     vector<float> signal(length);
+     unsigned int seed = 12345;
+     for (size_t i = 0; i < length; ++i)
+     {
+          double t = i / double(VERIFY_SAMPLE_RATE);
+          seed = seed * 1103515245u + 12345u;
+          double noise = ((seed >> 16) & 0x7FFF) / 16384.0 - 1.0;
+          double chirp = sin(2.0 * M_PI * (50.0 + 400.0 * t) * t);
+          double tones = 0.3 * sin(2.0 * M_PI * 440.0 * t) + 0.2 * sin(2.0 * M_PI * 1000.0 * t);
+          double fade = min(1.0, max(0.0, 8.0 * (length - i) / double(length) - 1.0));
+          signal[i] = static_cast<float>(fade * (0.4 * chirp + tones + 0.05 * noise));
+     }
+     return signal;
+}
+
+static double maxError(const vector<float> &expected, const vector<float> &actual)
+{
+     if (expected.size() != actual.size())
+          return INFINITY;
+     double error = 0.0;
+     for (size_t i = 0; i < expected.size(); ++i)
+          error = max(error, fabs(double(expected[i]) - actual[i]));
+     return error;
+}
+
+// Runs a filter wrapper with its timing output suppressed.
+static void quietly(const function<void()> &run)
+{
+     streambuf *saved = cout.rdbuf(nullptr);
+     run();
+     cout.rdbuf(saved);
+}
+
+static vf_view viewOf(const vector<float> &data)
+{
+     vf_view view = {data.data(), data.size(), 1};
+     return view;
+}
+
+static vf_buffer bufferOf(vector<float> &data)
+{
+     vf_buffer buffer = {data.data(), data.size(), 1};
+     return buffer;
+}
+
+struct VerifyState
+{
+     int failures;
+};
+
+static void check(VerifyState &state, const string &name, double error, double tolerance)
+{
+     bool ok = error <= tolerance;
+     cout << "    " << (ok ? "ok  " : "FAIL") << " " << name << ": max error " << error
+          << " (tolerance " << tolerance << ")" << endl;
+     if (!ok)
+          ++state.failures;
+}
+
+static void verifyOutputs(VerifyState &state, const vector<float> &signal)
+{
+     size_t half = signal.size() / 2;
+     vector<float> first(signal.begin(), signal.begin() + half);
+     vector<float> second(signal.begin() + half, signal.end());
+
+     cout << "Output checks on " << signal.size() << " samples:" << endl;
+
+     vector<float> expected = referenceBandpass(signal, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH);
+     vector<float> parallel = signal, library(signal.size()), streamed = first, rest = second;
+     quietly([&] { applyBandPassFilter(parallel, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH); });
+     vf_bandpass(viewOf(signal), bufferOf(library), VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH, 0, nullptr);
+     quietly([&] {
+          applyBandPassFilter(streamed, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH, 0);
+          applyBandPassFilter(rest, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH, half);
+     });
+     streamed.insert(streamed.end(), rest.begin(), rest.end());
+     check(state, "bandpass parallel vs serial", maxError(expected, parallel), 0.0);
+     check(state, "bandpass library vs serial", maxError(expected, library), 0.0);
+     check(state, "bandpass streamed vs serial", maxError(expected, streamed), 0.0);
+
+     expected = referenceNotch(signal, VERIFY_SAMPLE_RATE, NOTCH_FREQUENCY, NOTCH_ORDER);
+     parallel = signal;
+     streamed = first;
+     rest = second;
+     quietly([&] {
+          applyNotchFilter(parallel, VERIFY_SAMPLE_RATE, NOTCH_FREQUENCY, NOTCH_ORDER);
+          applyNotchFilter(streamed, VERIFY_SAMPLE_RATE, NOTCH_FREQUENCY, NOTCH_ORDER, 0);
+          applyNotchFilter(rest, VERIFY_SAMPLE_RATE, NOTCH_FREQUENCY, NOTCH_ORDER, half);
+     });
+     streamed.insert(streamed.end(), rest.begin(), rest.end());
+     check(state, "notch parallel vs serial", maxError(expected, parallel), 0.0);
+     check(state, "notch streamed vs serial", maxError(expected, streamed), 0.0);
+
+     expected = referenceFIR(signal, FIR_COEFFICIENTS);
+     parallel = signal;
+     streamed = first;
+     rest = second;
+     vector<float> history, streamHistory;
+     quietly([&] {
+          applyFIRFilter(parallel, FIR_COEFFICIENTS, history);
+          applyFIRFilter(streamed, FIR_COEFFICIENTS, streamHistory);
+          applyFIRFilter(rest, FIR_COEFFICIENTS, streamHistory);
+     });
+     streamed.insert(streamed.end(), rest.begin(), rest.end());
+     check(state, "fir parallel vs serial", maxError(expected, parallel), 0.0);
+     check(state, "fir streamed vs serial", maxError(expected, streamed), 0.0);
+
+     expected = referenceIIR(signal, IIR_FEEDFORWARD, IIR_FEEDBACK);
+     parallel = signal;
+     streamed = first;
+     rest = second;
+     vector<float> inputHistory, outputHistory, streamInput, streamOutput;
+     quietly([&] {
+          applyIIRFilter(parallel, IIR_FEEDFORWARD, IIR_FEEDBACK, inputHistory, outputHistory);
+          applyIIRFilter(streamed, IIR_FEEDFORWARD, IIR_FEEDBACK, streamInput, streamOutput);
+          applyIIRFilter(rest, IIR_FEEDFORWARD, IIR_FEEDBACK, streamInput, streamOutput);
+     });
+     streamed.insert(streamed.end(), rest.begin(), rest.end());
+     vector<float> fast(signal.size()), fastInput(IIR_FEEDFORWARD.size() - 1, 0.0f), fastOutput(IIR_FEEDBACK.size() - 1, 0.0f);
+     vf_fir(viewOf(signal), bufferOf(fast), IIR_FEEDFORWARD.data(), IIR_FEEDFORWARD.size(), fastInput.data(), nullptr);
+     int flushed = vf_set_flush_denormals(1);
+     vf_iir_feedback_double(bufferOf(fast), IIR_FEEDBACK.data(), IIR_FEEDBACK.size(), fastOutput.data());
+     vf_set_flush_denormals(flushed);
+     check(state, "iir parallel vs serial", maxError(expected, parallel), 0.0);
+     check(state, "iir streamed vs serial", maxError(expected, streamed), 0.0);
+     check(state, "iir fast vs serial", maxError(expected, fast), 1e-5);
+
+     for (size_t factor : {size_t(2), size_t(3)})
+     {
+          vector<float> taps(RESAMPLER_TAPS_PER_PHASE * factor + 1);
+          vf_design_lowpass(taps.data(), taps.size(), RESAMPLER_PASSBAND * 0.5f / factor);
+
+          vector<float> decimated(vf_decimated_length(signal.size(), factor));
+          vf_decimate(viewOf(signal), bufferOf(decimated), factor, taps.data(), taps.size(), nullptr, nullptr);
+          string suffix = " by " + to_string(factor) + " vs serial";
+          check(state, "decimate simd" + suffix, maxError(referenceDecimate(signal, factor, taps), decimated), 1e-5);
+
+          size_t split = half / factor * factor;
+          vector<float> head(vf_decimated_length(split, factor)), tail(decimated.size() - head.size());
+          vector<float> resampleHistory(taps.size() - 1, 0.0f);
+          vf_view headView = {signal.data(), split, 1}, tailView = {signal.data() + split, signal.size() - split, 1};
+          vf_decimate(headView, bufferOf(head), factor, taps.data(), taps.size(), resampleHistory.data(), nullptr);
+          vf_decimate(tailView, bufferOf(tail), factor, taps.data(), taps.size(), resampleHistory.data(), nullptr);
+          head.insert(head.end(), tail.begin(), tail.end());
+          check(state, "decimate streamed by " + to_string(factor) + " vs one pass", maxError(decimated, head), 0.0);
+
+          vector<float> interpolated(decimated.size() * factor);
+          vf_interpolate(viewOf(decimated), bufferOf(interpolated), factor, taps.data(), taps.size(), nullptr, nullptr);
+          check(state, "interpolate simd" + suffix,
+                maxError(referenceInterpolate(decimated, factor, taps), interpolated), 1e-5);
+     }
+
+     vector<float> mask(SPECTRAL_FRAME_SIZE / 2 + 1, 1.0f), identity(signal.size()), serialStft(signal.size());
+     vf_stft_filter(viewOf(signal), bufferOf(identity), SPECTRAL_FRAME_SIZE, mask.data(), nullptr);
+     check(state, "stft unit mask vs input", maxError(signal, identity), 1e-5);
+
+     vf_bandpass_mask(mask.data(), SPECTRAL_FRAME_SIZE, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH);
+     vf_notch_mask(mask.data(), SPECTRAL_FRAME_SIZE, VERIFY_SAMPLE_RATE, NOTCH_FREQUENCY, NOTCH_ORDER);
+     parallel = signal;
+     vf_stft_filter(viewOf(signal), bufferOf(serialStft), SPECTRAL_FRAME_SIZE, mask.data(), nullptr);
+     quietly([&] { applySpectralFilter(parallel, 1, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH, NOTCH_FREQUENCY, NOTCH_ORDER, {}, {}); });
+     check(state, "stft parallel vs serial", maxError(serialStft, parallel), 0.0);
+}
+
+// Every pooled filter again under the sequential policy; the chunking must
+// not change a single bit.
+static void verifyPolicies(VerifyState &state, const vector<float> &signal)
+{
+     vector<pair<string, function<void(vector<float> &)>>> filters = {
+         {"bandpass", [](vector<float> &d) { applyBandPassFilter(d, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH); }},
+         {"notch", [](vector<float> &d) { applyNotchFilter(d, VERIFY_SAMPLE_RATE, NOTCH_FREQUENCY, NOTCH_ORDER); }},
+         {"fir", [](vector<float> &d) { vector<float> h; applyFIRFilter(d, FIR_COEFFICIENTS, h); }},
+         {"iir", [](vector<float> &d) { vector<float> i, o; applyIIRFilter(d, IIR_FEEDFORWARD, IIR_FEEDBACK, i, o); }},
+         {"stft", [](vector<float> &d) {
+               applySpectralFilter(d, 1, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH, NOTCH_FREQUENCY, NOTCH_ORDER, {}, {});
+          }},
+     };
+
+     ExecutionPolicy saved = executionPolicy();
+     for (const auto &filter : filters)
+     {
+          vector<float> sequential = signal, parallel = signal;
+          setExecutionPolicy(SEQUENTIAL_POLICY);
+          quietly([&] { filter.second(sequential); });
+          setExecutionPolicy(PARALLEL_POLICY);
+          quietly([&] { filter.second(parallel); });
+          check(state, filter.first + " sequential vs parallel policy", maxError(sequential, parallel), 0.0);
+     }
+     setExecutionPolicy(saved);
+}
+
+// Best of VERIFY_TIMING_RUNS, in millions of samples per second.
+static double throughput(const vector<float> &signal, const function<void(vector<float> &)> &run)
+{
+     double best = 0.0;
+     for (int i = 0; i < VERIFY_TIMING_RUNS; ++i)
+     {
+          vector<float> data = signal;
+          auto start = chrono::high_resolution_clock::now();
+          quietly([&] { run(data); });
+          auto end = chrono::high_resolution_clock::now();
+          double seconds = chrono::duration<double>(end - start).count();
+          best = max(best, signal.size() / seconds / 1e6);
+     }
+     return best;
+}
+
+// A missing baseline fails the check; one is only written on request, so a
+// fresh checkout cannot pass the speed check by recording its own numbers.
+static void verifyThroughput(VerifyState &state, const vector<float> &signal, const string &baselineFile, bool record)
+{
+     vector<float> mask(SPECTRAL_FRAME_SIZE / 2 + 1, 1.0f), taps(RESAMPLER_TAPS_PER_PHASE * 2 + 1);
+     vf_design_lowpass(taps.data(), taps.size(), RESAMPLER_PASSBAND * 0.25f);
+
+     vector<pair<string, double>> measured = {
+         {"bandpass", throughput(signal, [](vector<float> &d) { applyBandPassFilter(d, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH); })},
+         {"notch", throughput(signal, [](vector<float> &d) { applyNotchFilter(d, VERIFY_SAMPLE_RATE, NOTCH_FREQUENCY, NOTCH_ORDER); })},
+         {"fir", throughput(signal, [](vector<float> &d) { vector<float> h; applyFIRFilter(d, FIR_COEFFICIENTS, h); })},
+         {"iir", throughput(signal, [](vector<float> &d) { vector<float> i, o; applyIIRFilter(d, IIR_FEEDFORWARD, IIR_FEEDBACK, i, o); })},
+         {"decimate", throughput(signal, [&](vector<float> &d) {
+               vector<float> out(vf_decimated_length(d.size(), 2));
+               vf_decimate(viewOf(d), bufferOf(out), 2, taps.data(), taps.size(), nullptr, nullptr);
+          })},
+         {"stft", throughput(signal, [](vector<float> &d) {
+               applySpectralFilter(d, 1, VERIFY_SAMPLE_RATE, BANDPASS_BANDWIDTH, NOTCH_FREQUENCY, NOTCH_ORDER, {}, {});
+          })},
+     };
+
+     cout << "Throughput (million samples per second, best of " << VERIFY_TIMING_RUNS << ", "
+          << executionPolicyName() << " policy):" << endl;
+     if (record)
+     {
+          if (state.failures > 0)
+          {
+               cerr << "Not recording a throughput baseline while output checks fail" << endl;
+               return;
+          }
+          ofstream out(baselineFile);
+          for (const auto &entry : measured)
+          {
+               out << entry.first << " " << entry.second << "\n";
+               cout << "    " << entry.first << ": " << entry.second << endl;
+          }
+          out.close();
+          if (!out)
+          {
+               cerr << "Error writing throughput baseline: " << baselineFile << endl;
+               ++state.failures;
+               return;
+          }
+          cout << "Recorded throughput baseline in " << baselineFile << endl;
+          return;
+     }
+
+     map<string, double> baseline;
+     ifstream in(baselineFile);
+     string name;
+     double value;
+     while (in >> name >> value)
+          baseline[name] = value;
+     if (baseline.empty())
+     {
+          cerr << "No throughput baseline in " << baselineFile << "; record one with --record-baseline "
+               << baselineFile << endl;
+          ++state.failures;
+          return;
+     }
+
+     for (const auto &entry : measured)
+     {
+          auto found = baseline.find(entry.first);
+          double floor = found == baseline.end() ? 0.0 : found->second * (1.0 - VERIFY_THROUGHPUT_TOLERANCE);
+          bool ok = entry.second >= floor;
+          cout << "    " << (ok ? "ok  " : "FAIL") << " " << entry.first << ": " << entry.second
+               << " (baseline " << (found == baseline.end() ? 0.0 : found->second) << ", minimum " << floor << ")" << endl;
+          if (!ok)
+               ++state.failures;
+     }
+}
+
+int runVerify(const string &baselineFile, bool record)
+{
+     VerifyState state = {0};
+     vector<float> signal = generateSignal(VERIFY_SAMPLES);
+
+     verifyOutputs(state, signal);
+     verifyPolicies(state, signal);
+     verifyThroughput(state, signal, baselineFile, record);
+
+     if (state.failures > 0)
+     {
+          cerr << state.failures << " verification check(s) failed" << endl;
+          return 1;
+     }
+     cout << "All verification checks passed" << endl;
+     return 0;
+}
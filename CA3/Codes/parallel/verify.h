@@ -0,0 +1,18 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <string>
+
+using namespace std;
+
+// Differential self-check. Runs every filter engine (serial reference
+// loops, the library without an executor, the pooled parallel filters,
+// streamed halves with carried state, the SIMD resamplers and the STFT
+// engine) on generated signals and compares their outputs within per-check
+// tolerances. Throughput of the parallel engines is then compared against
+// the baseline file, or written to it when record is set. Returns nonzero
+// if any output differs, the baseline is missing, or any engine is slower
+// than the baseline allows.
+int runVerify(const string &baselineFile, bool record);
+
+#endif
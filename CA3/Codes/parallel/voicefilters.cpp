@@ -0,0 +1,798 @@
+#include "voicefilters.h"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <complex>
+#include <new>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+
+struct ChunkRange
+{
+     size_t start;
+     size_t end;
+};
+
+static size_t chunkCount(const vf_executor *executor, size_t length)
+{
+     size_t chunks = (executor && executor->concurrency > 0) ? executor->concurrency : 1;
+     return max<size_t>(1, min(chunks, length));
+}
+
+static ChunkRange chunkRange(size_t length, size_t chunks, size_t index)
+{
+     ChunkRange range = {length * index / chunks, length * (index + 1) / chunks};
+     return range;
+}
+
+static void runTasks(const vf_executor *executor, size_t count, vf_task task, void *arg)
+{
+     if (executor && executor->parallel_for && count > 1)
+     {
+          executor->parallel_for(executor->context, count, task, arg);
+          return;
+     }
+     for (size_t i = 0; i < count; ++i)
+          task(arg, i);
+}
+
+static bool validView(const float *data, size_t length)
+{
+     return data || length == 0;
+}
+
+// Time-varying gains. Both compute "frequency" as 1 / t for the absolute
+// sample position, matching the original VoiceFilters filters bit for bit.
+static float bandpassGain(size_t k, float sampleRate, float bandwidth)
+{
+     float t = static_cast<float>(k) / sampleRate;
+     float freq = (t > 0) ? 1.0f / t : 0.0f;
+     float deltaF = bandwidth;
+     return (freq * freq) / (freq * freq + deltaF * deltaF);
+}
+
+static float notchGain(size_t k, float sampleRate, float notchFreq, int order)
+{
+     float t = static_cast<float>(k) / sampleRate;
+     float freq = (t > 0) ? 1.0f / t : 0.0f;
+     return 1.0f / (pow(freq / notchFreq, 2 * order) + 1);
+}
+
+struct GainTask
+{
+     vf_view in;
+     vf_buffer out;
+     float *gains;
+     const float *precomputed;
+     float sampleRate;
+     float parameter;
+     int order;
+     bool notch;
+     size_t origin;
+     size_t chunks;
+};
+
+static void gainChunk(void *arg, size_t index)
+{
+     GainTask *task = static_cast<GainTask *>(arg);
+     size_t length = task->gains ? task->out.length : task->in.length;
+     ChunkRange range = chunkRange(length, task->chunks, index);
+
+     for (size_t i = range.start; i < range.end; ++i)
+     {
+          float h;
+          if (task->precomputed)
+               h = task->precomputed[i];
+          else if (task->notch)
+               h = notchGain(task->origin + i, task->sampleRate, task->parameter, task->order);
+          else
+               h = bandpassGain(task->origin + i, task->sampleRate, task->parameter);
+
+          if (task->gains)
+               task->gains[i] = h;
+          else
+               task->out.data[i * task->out.stride] = h * task->in.data[i * task->in.stride];
+     }
+}
+
+static int runGains(GainTask &task, size_t length, const vf_executor *executor)
+{
+     task.chunks = chunkCount(executor, length);
+     runTasks(executor, task.chunks, gainChunk, &task);
+     return VF_OK;
+}
+
+int vf_bandpass(vf_view in, vf_buffer out, float sample_rate, float bandwidth, size_t origin,
+                const vf_executor *executor)
+{
+     if (!validView(in.data, in.length) || !validView(out.data, out.length) || out.length < in.length || sample_rate <= 0)
+          return VF_INVALID_ARGUMENT;
+
+     GainTask task = {in, out, nullptr, nullptr, sample_rate, bandwidth, 0, false, origin, 0};
+     return runGains(task, in.length, executor);
+}
+
+int vf_notch(vf_view in, vf_buffer out, float sample_rate, float notch_freq, int order, size_t origin,
+             const vf_executor *executor)
+{
+     if (!validView(in.data, in.length) || !validView(out.data, out.length) || out.length < in.length || sample_rate <= 0)
+          return VF_INVALID_ARGUMENT;
+
+     GainTask task = {in, out, nullptr, nullptr, sample_rate, notch_freq, order, true, origin, 0};
+     return runGains(task, in.length, executor);
+}
+
+int vf_bandpass_gains(float *gains, size_t length, float sample_rate, float bandwidth, size_t origin,
+                      const vf_executor *executor)
+{
+     if (!validView(gains, length) || sample_rate <= 0)
+          return VF_INVALID_ARGUMENT;
+
+     vf_buffer out = {gains, length, 1};
+     GainTask task = {vf_view(), out, gains, nullptr, sample_rate, bandwidth, 0, false, origin, 0};
+     return runGains(task, length, executor);
+}
+
+int vf_notch_gains(float *gains, size_t length, float sample_rate, float notch_freq, int order, size_t origin,
+                   const vf_executor *executor)
+{
+     if (!validView(gains, length) || sample_rate <= 0)
+          return VF_INVALID_ARGUMENT;
+
+     vf_buffer out = {gains, length, 1};
+     GainTask task = {vf_view(), out, gains, nullptr, sample_rate, notch_freq, order, true, origin, 0};
+     return runGains(task, length, executor);
+}
+
+int vf_apply_gains(vf_view in, vf_buffer out, const float *gains, const vf_executor *executor)
+{
+     if (!validView(in.data, in.length) || !validView(out.data, out.length) || !validView(gains, in.length) ||
+         out.length < in.length)
+          return VF_INVALID_ARGUMENT;
+
+     GainTask task = {in, out, nullptr, gains, 0.0f, 0.0f, 0, false, 0, 0};
+     return runGains(task, in.length, executor);
+}
+
+static float sampleBefore(vf_view in, const float *history, size_t historyLength, size_t position, size_t back)
+{
+     if (position >= back)
+          return in.data[(position - back) * in.stride];
+     return history ? history[historyLength + position - back] : 0.0f;
+}
+
+// Returns the last historyLength samples of history followed by in.
+static vector<float> nextHistory(vf_view in, const float *history, size_t historyLength)
+{
+     vector<float> next(historyLength);
+     for (size_t k = 0; k < historyLength; ++k)
+          next[k] = sampleBefore(in, history, historyLength, in.length, historyLength - k);
+     return next;
+}
+
+// Convolution runs over tiles of the output, several per worker so uneven
+// progress evens out, each at least FIR_MIN_TILE samples long so a task is
+// a long uninterrupted kernel. Every tile copies its halo (the n - 1 inputs
+// before it, snapshotted before any output is written, which keeps in-place
+// filtering safe) and its own inputs into a private cache-line aligned
+// window, accumulates a private output tile coefficient by coefficient, and
+// then copies the tile out. Tile boundaries sit on cache-line boundaries of
+// the output, so no two workers ever write the same line. Each output still
+// sums its products in coefficient order, so results are bit-identical to
+// the direct loop.
+static const size_t CACHE_LINE_BYTES = 64;
+static const size_t CACHE_LINE_FLOATS = CACHE_LINE_BYTES / sizeof(float);
+static const size_t FIR_MIN_TILE = 4096;
+static const size_t FIR_TILES_PER_WORKER = 4;
+static const size_t FIR_BLOCK = 1024;
+
+// Allocated through operator new, so a host that counts heap use (as
+// VoiceFilters does) sees the tiles too; operator new throws bad_alloc when
+// the window cannot be allocated, like any other allocation made by a task.
+class AlignedBuffer
+{
+public:
+     explicit AlignedBuffer(size_t length)
+     {
+          memory = static_cast<char *>(operator new(length * sizeof(float) + CACHE_LINE_BYTES));
+          uintptr_t address = reinterpret_cast<uintptr_t>(memory);
+          data = reinterpret_cast<float *>(memory + (CACHE_LINE_BYTES - address % CACHE_LINE_BYTES) % CACHE_LINE_BYTES);
+     }
+     ~AlignedBuffer()
+     {
+          operator delete(memory);
+     }
+
+     float *data;
+
+private:
+     AlignedBuffer(const AlignedBuffer &);
+     AlignedBuffer &operator=(const AlignedBuffer &);
+
+     char *memory;
+};
+
+struct ConvolutionTask
+{
+     vf_view in;
+     vf_buffer out;
+     const float *coefficients;
+     size_t numCoefficients;
+     size_t alignOffset;
+     size_t tileLength;
+     size_t tiles;
+     vector<float> halos;
+};
+
+static ChunkRange tileRange(const ConvolutionTask *task, size_t index)
+{
+     size_t length = task->in.length;
+     ChunkRange range;
+     range.start = index == 0 ? 0 : min(length, task->alignOffset + index * task->tileLength);
+     range.end = index + 1 == task->tiles ? length : min(length, task->alignOffset + (index + 1) * task->tileLength);
+     return range;
+}
+
+static void convolutionTile(void *arg, size_t index)
+{
+     ConvolutionTask *task = static_cast<ConvolutionTask *>(arg);
+     ChunkRange range = tileRange(task, index);
+     size_t length = range.end - range.start;
+     size_t haloLength = task->numCoefficients - 1;
+     if (length == 0)
+          return;
+
+     AlignedBuffer window(haloLength + length), tile(length);
+     copy(task->halos.begin() + index * haloLength, task->halos.begin() + (index + 1) * haloLength, window.data);
+     for (size_t i = 0; i < length; ++i)
+          window.data[haloLength + i] = task->in.data[(range.start + i) * task->in.stride];
+
+     for (size_t block = 0; block < length; block += FIR_BLOCK)
+     {
+          size_t blockEnd = min(length, block + FIR_BLOCK);
+          float *acc = tile.data;
+          for (size_t i = block; i < blockEnd; ++i)
+               acc[i] = 0.0f;
+          for (size_t j = 0; j < task->numCoefficients; ++j)
+          {
+               float coefficient = task->coefficients[j];
+               const float *x = window.data + haloLength - j;
+               for (size_t i = block; i < blockEnd; ++i)
+                    acc[i] += coefficient * x[i];
+          }
+     }
+
+     for (size_t i = 0; i < length; ++i)
+          task->out.data[(range.start + i) * task->out.stride] = tile.data[i];
+}
+
+static void convolve(vf_view in, vf_buffer out, const float *coefficients, size_t numCoefficients,
+                     const float *history, const vf_executor *executor)
+{
+     ConvolutionTask task;
+     task.in = in;
+     task.out = out;
+     task.coefficients = coefficients;
+     task.numCoefficients = numCoefficients;
+
+     // Samples until the output reaches a cache-line boundary; strided
+     // outputs interleave with other channels anyway, so they are not aligned.
+     uintptr_t address = reinterpret_cast<uintptr_t>(out.data);
+     task.alignOffset = 0;
+     if (out.stride == 1 && address % sizeof(float) == 0)
+          task.alignOffset = min(in.length, (CACHE_LINE_BYTES - address % CACHE_LINE_BYTES) % CACHE_LINE_BYTES / sizeof(float));
+
+     size_t workers = (executor && executor->concurrency > 0) ? executor->concurrency : 1;
+     size_t target = (in.length + workers * FIR_TILES_PER_WORKER - 1) / (workers * FIR_TILES_PER_WORKER);
+     task.tileLength = (max(target, FIR_MIN_TILE) + CACHE_LINE_FLOATS - 1) / CACHE_LINE_FLOATS * CACHE_LINE_FLOATS;
+     size_t aligned = in.length - task.alignOffset;
+     task.tiles = max<size_t>(1, (aligned + task.tileLength - 1) / task.tileLength);
+
+     size_t haloLength = numCoefficients - 1;
+     task.halos.resize(task.tiles * haloLength);
+     for (size_t t = 0; t < task.tiles; ++t)
+     {
+          size_t start = tileRange(&task, t).start;
+          for (size_t k = 0; k < haloLength; ++k)
+               task.halos[t * haloLength + k] = sampleBefore(in, history, haloLength, start, haloLength - k);
+     }
+
+     runTasks(executor, task.tiles, convolutionTile, &task);
+}
+
+int vf_fir(vf_view in, vf_buffer out, const float *coefficients, size_t num_coefficients,
+           float *history, const vf_executor *executor)
+{
+     if (!validView(in.data, in.length) || !validView(out.data, out.length) || out.length < in.length ||
+         !coefficients || num_coefficients == 0)
+          return VF_INVALID_ARGUMENT;
+
+     size_t historyLength = num_coefficients - 1;
+     vector<float> next;
+     if (history)
+          next = nextHistory(in, history, historyLength);
+
+     convolve(in, out, coefficients, num_coefficients, history, executor);
+
+     if (history)
+          copy(next.begin(), next.end(), history);
+     return VF_OK;
+}
+
+int vf_iir_feedback(vf_buffer data, const float *feedback, size_t num_feedback, float *output_history)
+{
+     if (!validView(data.data, data.length) || !feedback || num_feedback == 0)
+          return VF_INVALID_ARGUMENT;
+
+     size_t historyLength = num_feedback - 1;
+     float *y = data.data;
+     ptrdiff_t stride = data.stride;
+     for (size_t i = 0; i < data.length; ++i)
+     {
+          float acc = y[i * stride];
+          for (size_t j = 1; j < num_feedback; ++j)
+          {
+               float previous = (i >= j) ? y[(i - j) * stride]
+                                         : (output_history ? output_history[historyLength + i - j] : 0.0f);
+               acc -= feedback[j] * previous;
+          }
+          y[i * stride] = acc;
+     }
+
+     if (output_history)
+     {
+          vf_view produced = {data.data, data.length, data.stride};
+          vector<float> next = nextHistory(produced, output_history, historyLength);
+          copy(next.begin(), next.end(), output_history);
+     }
+     return VF_OK;
+}
+
+int vf_iir_feedback_double(vf_buffer data, const float *feedback, size_t num_feedback, float *output_history)
+{
+     if (!validView(data.data, data.length) || !feedback || num_feedback == 0)
+          return VF_INVALID_ARGUMENT;
+
+     // state[k] is the output k + 1 samples back; it only ever holds
+     // doubles, so rounding to float happens once per stored sample.
+     size_t historyLength = num_feedback - 1;
+     vector<double> coefficients(feedback, feedback + num_feedback);
+     vector<double> state(historyLength, 0.0);
+     if (output_history)
+          for (size_t k = 0; k < historyLength; ++k)
+               state[k] = output_history[historyLength - 1 - k];
+
+     float *y = data.data;
+     ptrdiff_t stride = data.stride;
+     for (size_t i = 0; i < data.length; ++i)
+     {
+          double acc = y[i * stride];
+          for (size_t j = 1; j < num_feedback; ++j)
+               acc -= coefficients[j] * state[j - 1];
+          if (historyLength > 0)
+          {
+               copy_backward(state.begin(), state.end() - 1, state.end());
+               state[0] = acc;
+          }
+          y[i * stride] = static_cast<float>(acc);
+     }
+
+     if (output_history)
+          for (size_t k = 0; k < historyLength; ++k)
+               output_history[historyLength - 1 - k] = static_cast<float>(state[k]);
+     return VF_OK;
+}
+
+int vf_set_flush_denormals(int enable)
+{
+#if defined(__SSE__)
+     const unsigned int flushBits = _MM_FLUSH_ZERO_ON | 0x0040; /* FTZ | DAZ */
+     unsigned int csr = _mm_getcsr();
+     _mm_setcsr(enable ? (csr | flushBits) : (csr & ~flushBits));
+     return (csr & flushBits) == flushBits;
+#elif defined(__aarch64__)
+     unsigned long fpcr;
+     __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+     unsigned long next = enable ? (fpcr | (1ul << 24)) : (fpcr & ~(1ul << 24));
+     __asm__ volatile("msr fpcr, %0" : : "r"(next));
+     return (fpcr >> 24) & 1;
+#else
+     (void)enable;
+     return 0;
+#endif
+}
+
+int vf_iir(vf_view in, vf_buffer out, const float *feedforward, size_t num_feedforward,
+           const float *feedback, size_t num_feedback, float *input_history, float *output_history,
+           const vf_executor *executor)
+{
+     if (!feedback || num_feedback == 0)
+          return VF_INVALID_ARGUMENT;
+
+     int status = vf_fir(in, out, feedforward, num_feedforward, input_history, executor);
+     if (status != VF_OK)
+          return status;
+
+     vf_buffer produced = {out.data, in.length, out.stride};
+     return vf_iir_feedback(produced, feedback, num_feedback, output_history);
+}
+
+// Four-wide dot product. With GCC/Clang vector extensions this compiles to
+// SSE/NEON multiply-adds on four independent lanes.
+static float dot(const float *a, const float *b, size_t n)
+{
+     size_t k = 0;
+     float sum = 0.0f;
+#if defined(__GNUC__)
+     typedef float float4 __attribute__((vector_size(16)));
+     float4 acc = {0.0f, 0.0f, 0.0f, 0.0f};
+     for (; k + 4 <= n; k += 4)
+     {
+          float4 va, vb;
+          memcpy(&va, a + k, sizeof(va));
+          memcpy(&vb, b + k, sizeof(vb));
+          acc += va * vb;
+     }
+     sum = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+     for (; k < n; ++k)
+          sum += a[k] * b[k];
+     return sum;
+}
+
+int vf_design_lowpass(float *taps, size_t num_taps, float cutoff)
+{
+     if (!taps || num_taps == 0 || cutoff <= 0.0f || cutoff >= 0.5f)
+          return VF_INVALID_ARGUMENT;
+
+     const double pi = 3.14159265358979323846;
+     double center = (num_taps - 1) / 2.0;
+     double sum = 0.0;
+     vector<double> design(num_taps);
+     for (size_t n = 0; n < num_taps; ++n)
+     {
+          double x = n - center;
+          double sinc = (x == 0.0) ? 2.0 * cutoff : sin(2.0 * pi * cutoff * x) / (pi * x);
+          double window = (num_taps == 1) ? 1.0 : 0.54 - 0.46 * cos(2.0 * pi * n / (num_taps - 1));
+          design[n] = sinc * window;
+          sum += design[n];
+     }
+
+     for (size_t n = 0; n < num_taps; ++n)
+          taps[n] = static_cast<float>(design[n] / sum);
+     return VF_OK;
+}
+
+size_t vf_decimated_length(size_t length, size_t factor)
+{
+     return factor == 0 ? 0 : (length + factor - 1) / factor;
+}
+
+// Both resamplers copy each chunk, plus the history it needs, into a private
+// contiguous window so the inner loop is a unit-stride dot product against
+// reversed taps regardless of the caller's strides.
+struct ResampleTask
+{
+     vf_view in;
+     vf_buffer out;
+     size_t factor;
+     size_t phaseLength;
+     vector<float> reversedTaps;
+     const float *history;
+     size_t chunks;
+};
+
+static vector<float> chunkWindow(const ResampleTask *task, size_t first, size_t last, size_t haloLength)
+{
+     vector<float> window(haloLength + last - first);
+     for (size_t k = 0; k < haloLength; ++k)
+          window[k] = sampleBefore(task->in, task->history, haloLength, first, haloLength - k);
+     for (size_t p = first; p < last; ++p)
+          window[haloLength + p - first] = task->in.data[p * task->in.stride];
+     return window;
+}
+
+static void decimateChunk(void *arg, size_t index)
+{
+     ResampleTask *task = static_cast<ResampleTask *>(arg);
+     ChunkRange range = chunkRange(vf_decimated_length(task->in.length, task->factor), task->chunks, index);
+     if (range.start == range.end)
+          return;
+
+     size_t numTaps = task->reversedTaps.size();
+     size_t first = range.start * task->factor;
+     size_t last = (range.end - 1) * task->factor + 1;
+     vector<float> window = chunkWindow(task, first, last, numTaps - 1);
+
+     for (size_t m = range.start; m < range.end; ++m)
+          task->out.data[m * task->out.stride] = dot(task->reversedTaps.data(), window.data() + (m - range.start) * task->factor, numTaps);
+}
+
+static void interpolateChunk(void *arg, size_t index)
+{
+     ResampleTask *task = static_cast<ResampleTask *>(arg);
+     ChunkRange range = chunkRange(task->in.length, task->chunks, index);
+     if (range.start == range.end)
+          return;
+
+     size_t phaseLength = task->phaseLength;
+     vector<float> window = chunkWindow(task, range.start, range.end, phaseLength - 1);
+
+     for (size_t n = range.start; n < range.end; ++n)
+     {
+          const float *samples = window.data() + (n - range.start);
+          for (size_t p = 0; p < task->factor; ++p)
+          {
+               float y = dot(task->reversedTaps.data() + p * phaseLength, samples, phaseLength);
+               task->out.data[(n * task->factor + p) * task->out.stride] = y * task->factor;
+          }
+     }
+}
+
+int vf_decimate(vf_view in, vf_buffer out, size_t factor, const float *taps, size_t num_taps,
+                float *history, const vf_executor *executor)
+{
+     if (!validView(in.data, in.length) || !validView(out.data, out.length) || factor == 0 ||
+         out.length < vf_decimated_length(in.length, factor) || !taps || num_taps == 0 || in.data == out.data)
+          return VF_INVALID_ARGUMENT;
+
+     ResampleTask task;
+     task.in = in;
+     task.out = out;
+     task.factor = factor;
+     task.phaseLength = num_taps;
+     task.reversedTaps.assign(taps, taps + num_taps);
+     reverse(task.reversedTaps.begin(), task.reversedTaps.end());
+     task.history = history;
+     task.chunks = chunkCount(executor, vf_decimated_length(in.length, factor));
+
+     vector<float> next;
+     if (history)
+          next = nextHistory(in, history, num_taps - 1);
+
+     runTasks(executor, task.chunks, decimateChunk, &task);
+
+     if (history)
+          copy(next.begin(), next.end(), history);
+     return VF_OK;
+}
+
+int vf_interpolate(vf_view in, vf_buffer out, size_t factor, const float *taps, size_t num_taps,
+                   float *history, const vf_executor *executor)
+{
+     if (!validView(in.data, in.length) || !validView(out.data, out.length) || factor == 0 ||
+         out.length < in.length * factor || !taps || num_taps == 0 || in.data == out.data)
+          return VF_INVALID_ARGUMENT;
+
+     // Phase p of the polyphase bank holds taps p, p + factor, p + 2 factor...
+     size_t phaseLength = vf_decimated_length(num_taps, factor);
+     ResampleTask task;
+     task.in = in;
+     task.out = out;
+     task.factor = factor;
+     task.phaseLength = phaseLength;
+     task.reversedTaps.assign(factor * phaseLength, 0.0f);
+     for (size_t p = 0; p < factor; ++p)
+          for (size_t k = 0; k < phaseLength && k * factor + p < num_taps; ++k)
+               task.reversedTaps[p * phaseLength + phaseLength - 1 - k] = taps[k * factor + p];
+     task.history = history;
+     task.chunks = chunkCount(executor, in.length);
+
+     vector<float> next;
+     if (history)
+          next = nextHistory(in, history, phaseLength - 1);
+
+     runTasks(executor, task.chunks, interpolateChunk, &task);
+
+     if (history)
+          copy(next.begin(), next.end(), history);
+     return VF_OK;
+}
+
+// Frequency responses for vf_stft_filter masks. Unlike vf_bandpass and
+// vf_notch these evaluate the same formulas at the real centre frequency of
+// each FFT bin.
+static size_t binCount(size_t frameSize)
+{
+     return frameSize / 2 + 1;
+}
+
+static float binFrequency(size_t bin, size_t frameSize, float sampleRate)
+{
+     return static_cast<float>(bin) * sampleRate / frameSize;
+}
+
+static bool validFrameSize(size_t frameSize)
+{
+     return frameSize >= 4 && (frameSize & (frameSize - 1)) == 0;
+}
+
+int vf_bandpass_mask(float *mask, size_t frame_size, float sample_rate, float bandwidth)
+{
+     if (!mask || !validFrameSize(frame_size) || sample_rate <= 0)
+          return VF_INVALID_ARGUMENT;
+
+     for (size_t bin = 0; bin < binCount(frame_size); ++bin)
+     {
+          float freq = binFrequency(bin, frame_size, sample_rate);
+          mask[bin] *= (freq * freq) / (freq * freq + bandwidth * bandwidth);
+     }
+     return VF_OK;
+}
+
+int vf_notch_mask(float *mask, size_t frame_size, float sample_rate, float notch_freq, int order)
+{
+     if (!mask || !validFrameSize(frame_size) || sample_rate <= 0 || notch_freq <= 0)
+          return VF_INVALID_ARGUMENT;
+
+     for (size_t bin = 0; bin < binCount(frame_size); ++bin)
+     {
+          float freq = binFrequency(bin, frame_size, sample_rate);
+          mask[bin] *= 1.0f / (pow(freq / notch_freq, 2 * order) + 1);
+     }
+     return VF_OK;
+}
+
+int vf_eq_mask(float *mask, size_t frame_size, float sample_rate, const float *frequencies, const float *gains_db,
+               size_t num_points)
+{
+     if (!mask || !validFrameSize(frame_size) || sample_rate <= 0 || !frequencies || !gains_db || num_points == 0)
+          return VF_INVALID_ARGUMENT;
+     for (size_t i = 1; i < num_points; ++i)
+          if (frequencies[i] <= frequencies[i - 1])
+               return VF_INVALID_ARGUMENT;
+
+     size_t point = 0;
+     for (size_t bin = 0; bin < binCount(frame_size); ++bin)
+     {
+          float freq = binFrequency(bin, frame_size, sample_rate);
+          while (point < num_points && frequencies[point] <= freq)
+               ++point;
+
+          float db;
+          if (point == 0)
+               db = gains_db[0];
+          else if (point == num_points)
+               db = gains_db[num_points - 1];
+          else
+          {
+               float f0 = frequencies[point - 1], f1 = frequencies[point];
+               float w = (freq - f0) / (f1 - f0);
+               db = gains_db[point - 1] + w * (gains_db[point] - gains_db[point - 1]);
+          }
+          mask[bin] *= pow(10.0f, db / 20.0f);
+     }
+     return VF_OK;
+}
+
+// Short-time Fourier transform with periodic sqrt-Hann analysis and synthesis
+// windows at 50% overlap; their product sums to exactly one, so a unit mask
+// reconstructs the input. The first frame starts frame_size / 2 samples
+// before the signal so every sample is covered by two frames.
+struct StftTask
+{
+     vf_view in;
+     vf_buffer out;
+     size_t frameSize;
+     size_t hop;
+     const float *mask;
+     vector<float> window;
+     vector<complex<float>> twiddles;
+     vector<size_t> bitReverse;
+     size_t chunks;
+};
+
+static void fft(const StftTask *task, vector<complex<float>> &data, bool inverse)
+{
+     size_t n = data.size();
+     for (size_t i = 0; i < n; ++i)
+          if (i < task->bitReverse[i])
+               swap(data[i], data[task->bitReverse[i]]);
+
+     for (size_t span = 1; span < n; span <<= 1)
+     {
+          size_t step = n / (2 * span);
+          for (size_t start = 0; start < n; start += 2 * span)
+               for (size_t k = 0; k < span; ++k)
+               {
+                    complex<float> w = task->twiddles[k * step];
+                    if (inverse)
+                         w = conj(w);
+                    complex<float> odd = w * data[start + span + k];
+                    data[start + span + k] = data[start + k] - odd;
+                    data[start + k] += odd;
+               }
+     }
+}
+
+// Each chunk owns a range of output samples and transforms every frame that
+// overlaps it, so frames on a chunk boundary are computed by both
+// neighbours instead of sharing an accumulator.
+static void stftChunk(void *arg, size_t index)
+{
+     StftTask *task = static_cast<StftTask *>(arg);
+     ChunkRange range = chunkRange(task->in.length, task->chunks, index);
+     if (range.start == range.end)
+          return;
+
+     size_t n = task->frameSize, hop = task->hop;
+     vector<float> accumulated(range.end - range.start, 0.0f);
+     vector<complex<float>> spectrum(n);
+
+     for (size_t frame = range.start / hop; frame < (range.end + n - 1) / hop; ++frame)
+     {
+          // Frame positions are offset by n - hop, so sample i of the frame is
+          // input sample frame * hop + i - (n - hop).
+          for (size_t i = 0; i < n; ++i)
+          {
+               size_t shifted = frame * hop + i;
+               bool inside = shifted >= n - hop && shifted - (n - hop) < task->in.length;
+               float x = inside ? task->in.data[(shifted - (n - hop)) * task->in.stride] : 0.0f;
+               spectrum[i] = complex<float>(x * task->window[i], 0.0f);
+          }
+
+          fft(task, spectrum, false);
+          for (size_t bin = 0; bin <= n / 2; ++bin)
+          {
+               spectrum[bin] *= task->mask[bin];
+               if (bin != 0 && bin != n / 2)
+                    spectrum[n - bin] *= task->mask[bin];
+          }
+          fft(task, spectrum, true);
+
+          for (size_t i = 0; i < n; ++i)
+          {
+               size_t shifted = frame * hop + i;
+               if (shifted < n - hop + range.start || shifted >= n - hop + range.end)
+                    continue;
+               accumulated[shifted - (n - hop) - range.start] += spectrum[i].real() / n * task->window[i];
+          }
+     }
+
+     for (size_t p = range.start; p < range.end; ++p)
+          task->out.data[p * task->out.stride] = accumulated[p - range.start];
+}
+
+int vf_stft_filter(vf_view in, vf_buffer out, size_t frame_size, const float *mask, const vf_executor *executor)
+{
+     if (!validView(in.data, in.length) || !validView(out.data, out.length) || out.length < in.length ||
+         !validFrameSize(frame_size) || !mask || in.data == out.data)
+          return VF_INVALID_ARGUMENT;
+
+     const double pi = 3.14159265358979323846;
+     StftTask task;
+     task.in = in;
+     task.out = out;
+     task.frameSize = frame_size;
+     task.hop = frame_size / 2;
+     task.mask = mask;
+     task.window.resize(frame_size);
+     task.twiddles.resize(frame_size / 2);
+     task.bitReverse.resize(frame_size);
+     for (size_t i = 0; i < frame_size; ++i)
+          task.window[i] = static_cast<float>(sqrt(0.5 - 0.5 * cos(2.0 * pi * i / frame_size)));
+     for (size_t k = 0; k < frame_size / 2; ++k)
+          task.twiddles[k] = complex<float>(static_cast<float>(cos(2.0 * pi * k / frame_size)),
+                                            static_cast<float>(-sin(2.0 * pi * k / frame_size)));
+
+     size_t bits = 0;
+     while ((size_t(1) << bits) < frame_size)
+          ++bits;
+     for (size_t i = 0; i < frame_size; ++i)
+     {
+          size_t reversed = 0;
+          for (size_t b = 0; b < bits; ++b)
+               reversed |= ((i >> b) & 1) << (bits - 1 - b);
+          task.bitReverse[i] = reversed;
+     }
+     task.chunks = chunkCount(executor, in.length);
+
+     runTasks(executor, task.chunks, stftChunk, &task);
+     return VF_OK;
+}
@@ -0,0 +1,125 @@
+#ifndef VOICEFILTERS_H
+#define VOICEFILTERS_H
+
+#include <stddef.h>
+
+/*
+ * In-process filter kernels (libvoicefilters). The kernels work on strided
+ * views of caller memory, never print and never touch files; parallelism is
+ * delegated to a caller-supplied executor. Sample k of a view lives at
+ * data[k * stride], so one channel of interleaved audio is filtered by
+ * passing stride = channels. Input and output may be the same view.
+ *
+ * FIR and IIR histories hold the last (n - 1) samples before the view,
+ * oldest first, and are advanced in place so consecutive blocks of a stream
+ * can be filtered with the same state. NULL history means a zero state.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum
+{
+     VF_OK = 0,
+     VF_INVALID_ARGUMENT = -1
+};
+
+typedef struct vf_view
+{
+     const float *data;
+     size_t length;
+     ptrdiff_t stride;
+} vf_view;
+
+typedef struct vf_buffer
+{
+     float *data;
+     size_t length;
+     ptrdiff_t stride;
+} vf_buffer;
+
+typedef void (*vf_task)(void *arg, size_t index);
+
+/* Runs task(arg, i) for every i in [0, count) and returns once all have
+ * finished. concurrency is the number of chunks work is split into. */
+typedef struct vf_executor
+{
+     void (*parallel_for)(void *context, size_t count, vf_task task, void *arg);
+     void *context;
+     size_t concurrency;
+} vf_executor;
+
+/* origin is the absolute position of in.data[0] in the stream. */
+int vf_bandpass(vf_view in, vf_buffer out, float sample_rate, float bandwidth, size_t origin,
+                const vf_executor *executor);
+int vf_notch(vf_view in, vf_buffer out, float sample_rate, float notch_freq, int order, size_t origin,
+             const vf_executor *executor);
+
+/* Precomputed gain curves for the two filters above, and their application. */
+int vf_bandpass_gains(float *gains, size_t length, float sample_rate, float bandwidth, size_t origin,
+                      const vf_executor *executor);
+int vf_notch_gains(float *gains, size_t length, float sample_rate, float notch_freq, int order, size_t origin,
+                   const vf_executor *executor);
+int vf_apply_gains(vf_view in, vf_buffer out, const float *gains, const vf_executor *executor);
+
+int vf_fir(vf_view in, vf_buffer out, const float *coefficients, size_t num_coefficients,
+           float *history, const vf_executor *executor);
+
+/* The recursive half of vf_iir, run in place over already feedforward
+ * filtered samples. feedback[0] is taken to be 1 and is not read; the
+ * recursion is inherently sequential and ignores any executor. */
+int vf_iir_feedback(vf_buffer data, const float *feedback, size_t num_feedback, float *output_history);
+
+/* vf_iir_feedback with the recursion carried in double precision; samples
+ * and output_history stay float. Not bit-identical to vf_iir_feedback. */
+int vf_iir_feedback_double(vf_buffer data, const float *feedback, size_t num_feedback, float *output_history);
+
+/* Turns flush-to-zero and denormals-are-zero on or off for the calling
+ * thread (FZ on AArch64) and returns whether they were on. Decaying
+ * recursive tails otherwise run on subnormals, which x86 handles in
+ * microcode at a fraction of normal speed. */
+int vf_set_flush_denormals(int enable);
+int vf_iir(vf_view in, vf_buffer out, const float *feedforward, size_t num_feedforward,
+           const float *feedback, size_t num_feedback, float *input_history, float *output_history,
+           const vf_executor *executor);
+
+/* Windowed-sinc (Hamming) lowpass prototype with unity DC gain; cutoff is
+ * in cycles per input sample, 0 < cutoff < 0.5. */
+int vf_design_lowpass(float *taps, size_t num_taps, float cutoff);
+
+/* Polyphase resampling by an integer factor. vf_decimate keeps every
+ * factor-th sample of the lowpass filtered input and writes
+ * vf_decimated_length(in.length, factor) samples; only the kept outputs are
+ * computed. vf_interpolate writes in.length * factor samples through the
+ * factor polyphase branches of taps, scaled by factor to keep the level.
+ * Histories hold num_taps - 1 (decimate) or
+ * vf_decimated_length(num_taps, factor) - 1 (interpolate) input samples;
+ * streamed decimation blocks must be multiples of factor long. Resampling
+ * cannot run in place. */
+size_t vf_decimated_length(size_t length, size_t factor);
+int vf_decimate(vf_view in, vf_buffer out, size_t factor, const float *taps, size_t num_taps,
+                float *history, const vf_executor *executor);
+int vf_interpolate(vf_view in, vf_buffer out, size_t factor, const float *taps, size_t num_taps,
+                   float *history, const vf_executor *executor);
+
+/* Per-bin gain masks for vf_stft_filter: frame_size / 2 + 1 gains, one per
+ * bin from DC to Nyquist. Each function multiplies its response into mask,
+ * so start from all ones and combine as many as needed. vf_eq_mask
+ * interpolates gains_db linearly between strictly increasing frequencies
+ * (Hz) and holds the end values beyond them. */
+int vf_bandpass_mask(float *mask, size_t frame_size, float sample_rate, float bandwidth);
+int vf_notch_mask(float *mask, size_t frame_size, float sample_rate, float notch_freq, int order);
+int vf_eq_mask(float *mask, size_t frame_size, float sample_rate, const float *frequencies, const float *gains_db,
+               size_t num_points);
+
+/* Applies a per-bin gain mask through a windowed FFT with overlap-add
+ * resynthesis. frame_size must be a power of two; frames advance by half
+ * of it. Chunks are transformed in parallel; cannot run in place. */
+int vf_stft_filter(vf_view in, vf_buffer out, size_t frame_size, const float *mask, const vf_executor *executor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif